@@ -13,6 +13,11 @@ typedef enum {
 } AccountType;
 
 typedef struct {
+    // Dense identifier, unique within the AccountList that created the
+    // account. Never changes, even through renames, deletions and undos.
+    int id;
+    // The AccountList that created the account.
+    struct _AccountList *list;
     AccountType type;
     // Default currency of the account. Mostly determines how amounts are
     // displayed when viewing its entries listing.
@@ -4,7 +4,101 @@
 #include "accounts.h"
 #include "util.h"
 
+// Work shared between the threads of accounts_cook()
+typedef struct {
+    EntryList **lists;
+    int count;
+    // Index of the next list to cook
+    gint next;
+    gint failed;
+} CookJob;
+
 /* Private */
+static int
+_accounts_cmp_uncooked(const void *a, const void *b)
+{
+    const EntryList *e1 = *((EntryList **)a);
+    const EntryList *e2 = *((EntryList **)b);
+    return (e2->count - e2->cooked_until) - (e1->count - e1->cooked_until);
+}
+
+static gpointer
+_accounts_cook_worker(gpointer data)
+{
+    CookJob *job = data;
+    while (true) {
+        int index = g_atomic_int_add(&job->next, 1);
+        if (index >= job->count) {
+            break;
+        }
+        if (!entries_cook(job->lists[index])) {
+            g_atomic_int_set(&job->failed, 1);
+        }
+    }
+    return NULL;
+}
+
+static void
+_accounts_index_reset(AccountList *accounts)
+{
+    g_hash_table_remove_all(accounts->names);
+    g_hash_table_remove_all(accounts->numbers);
+    g_hash_table_remove_all(accounts->references);
+    accounts->indexed = 0;
+    accounts->collisions = 0;
+    accounts->unindexed = NULL;
+}
+
+// Indexes `key` -> `a` unless `key` is already taken. Returns false if it is.
+static bool
+_accounts_index_key(GHashTable *index, char *key, Account *a)
+{
+    if (key == NULL || key[0] == '\0') {
+        return true;
+    }
+    if (g_hash_table_contains(index, key)) {
+        return false;
+    }
+    g_hash_table_insert(index, key, a);
+    return true;
+}
+
+static void
+_accounts_unindex_key(GHashTable *index, char *key, Account *a)
+{
+    if (key != NULL && g_hash_table_lookup(index, key) == a) {
+        g_hash_table_remove(index, key);
+    }
+}
+
+// Indexes `a` under all its keys. When the same key is used by more than one
+// account, the first one wins.
+static void
+_accounts_index(AccountList *accounts, Account *a)
+{
+    bool ok = _accounts_index_key(accounts->names, a->name_key, a);
+    ok = _accounts_index_key(accounts->numbers, a->account_number, a) && ok;
+    ok = _accounts_index_key(accounts->references, a->reference, a) && ok;
+    if (!ok) {
+        accounts->collisions++;
+    }
+}
+
+// Index accounts that were added since our last call.
+static void
+_accounts_ensure_indexed(AccountList *accounts)
+{
+    while (accounts->indexed < accounts->count) {
+        Account *a = accounts->accounts[accounts->indexed];
+        if (a->name_key == NULL) {
+            // Freshly created, not initialized yet. We'll index it later.
+            break;
+        }
+        _accounts_index(accounts, a);
+        accounts->indexed++;
+    }
+}
+
 static void
 _add(AccountList *accounts, Account *account)
 {
@@ -29,22 +123,30 @@ accounts_init(AccountList *accounts, Currency *default_currency)
     accounts->default_currency = default_currency;
     accounts->accounts = NULL;
     accounts->count = 0;
-    accounts->a2entries = g_hash_table_new(g_str_hash, g_str_equal);
+    accounts->id2entries = NULL;
+    accounts->next_id = 0;
     // don't set a free func: unlike what the doc says, it's called on more
     // occasions than free(): it's called on remove() too. we don't want that.
     accounts->trashcan = g_ptr_array_new();
+    accounts->names = g_hash_table_new(g_str_hash, g_str_equal);
+    accounts->numbers = g_hash_table_new(g_str_hash, g_str_equal);
+    accounts->references = g_hash_table_new(g_str_hash, g_str_equal);
+    accounts->indexed = 0;
+    accounts->collisions = 0;
+    accounts->unindexed = NULL;
 }
 
 void
 accounts_deinit(AccountList *accounts)
 {
-    GHashTableIter iter;
-    g_hash_table_iter_init(&iter, accounts->a2entries);
-    gpointer _, entries;
-    while (g_hash_table_iter_next(&iter, &_, &entries)) {
-        free(entries);
+    for (int i=0; i<accounts->next_id; i++) {
+        entries_deinit(accounts->id2entries[i]);
+        free(accounts->id2entries[i]);
     }
-    g_hash_table_destroy(accounts->a2entries);
+    free(accounts->id2entries);
+    g_hash_table_destroy(accounts->names);
+    g_hash_table_destroy(accounts->numbers);
+    g_hash_table_destroy(accounts->references);
 
     for (int i=0; i<accounts->count; i++) {
         account_deinit(accounts->accounts[i]);
@@ -73,6 +175,14 @@ Account*
 accounts_create(AccountList *accounts)
 {
     Account *res = calloc(1, sizeof(Account));
+    res->id = accounts->next_id;
+    res->list = accounts;
+    accounts->next_id++;
+    accounts->id2entries = realloc(
+        accounts->id2entries, sizeof(EntryList*) * accounts->next_id);
+    EntryList *entries = malloc(sizeof(EntryList));
+    entries_init(entries, res);
+    accounts->id2entries[res->id] = entries;
     _add(accounts, res);
     return res;
 }
@@ -80,13 +190,54 @@ accounts_create(AccountList *accounts)
 EntryList*
 accounts_entries_for_account(AccountList *accounts, Account *account)
 {
-    EntryList *entries = g_hash_table_lookup(accounts->a2entries, account->name);
-    if (entries == NULL) {
-        entries = malloc(sizeof(EntryList));
-        entries_init(entries, account);
-        g_hash_table_insert(accounts->a2entries, account->name, entries);
+    if (account->id < accounts->next_id) {
+        EntryList *entries = accounts->id2entries[account->id];
+        if (entries->account == account) {
+            return entries;
+        }
+    }
+    // Not one of ours.
+    Account *found = accounts_find_by_name(accounts, account->name);
+    if (found == NULL) {
+        return NULL;
     }
-    return entries;
+    return accounts->id2entries[found->id];
+}
+
+bool
+accounts_cook(AccountList *accounts, int threads)
+{
+    CookJob job;
+    job.lists = malloc(sizeof(EntryList*) * accounts->next_id);
+    job.count = 0;
+    job.next = 0;
+    job.failed = 0;
+    for (int i=0; i<accounts->next_id; i++) {
+        EntryList *entries = accounts->id2entries[i];
+        if (entries->count > entries->cooked_until) {
+            job.lists[job.count] = entries;
+            job.count++;
+        }
+    }
+    if (threads > job.count) {
+        threads = job.count;
+    }
+    if (threads > 1) {
+        qsort(job.lists, job.count, sizeof(EntryList*), _accounts_cmp_uncooked);
+        GThread **workers = malloc(sizeof(GThread*) * (threads - 1));
+        for (int i=0; i<threads-1; i++) {
+            workers[i] = g_thread_new("cook", _accounts_cook_worker, &job);
+        }
+        _accounts_cook_worker(&job);
+        for (int i=0; i<threads-1; i++) {
+            g_thread_join(workers[i]);
+        }
+        free(workers);
+    } else {
+        _accounts_cook_worker(&job);
+    }
+    free(job.lists);
+    return !job.failed;
 }
 
 bool
@@ -112,6 +263,9 @@ accounts_remove(AccountList *accounts, Account *target)
     accounts->accounts = realloc(
         accounts->accounts, sizeof(Account*) * accounts->count);
     g_ptr_array_add(accounts->trashcan, target);
+    // Positions changed and `target` might have been shadowing another
+    // account's number. Removals are rare, we simply re-index.
+    _accounts_index_reset(accounts);
     return true;
 }
 
@@ -122,17 +276,56 @@ accounts_rename(AccountList *accounts, Account *target, const char *newname)
     if (found != NULL && found != target) {
         return false;
     }
-    EntryList *entries = g_hash_table_lookup(accounts->a2entries, target->name);
-    if (entries != NULL) {
-        g_hash_table_remove(accounts->a2entries, target->name);
+    // Our old name_key is about to be freed, it can't stay in our index.
+    bool indexed = g_hash_table_lookup(accounts->names, target->name_key) == target;
+    if (indexed) {
+        g_hash_table_remove(accounts->names, target->name_key);
     }
     account_name_set(target, newname);
-    if (entries != NULL) {
-        g_hash_table_insert(accounts->a2entries, target->name, entries);
+    if (indexed) {
+        g_hash_table_insert(accounts->names, target->name_key, target);
     }
     return true;
 }
 
+void
+accounts_unindex(AccountList *accounts, Account *account)
+{
+    if (accounts->collisions > 0) {
+        // Another account might be shadowed by one of our keys and we don't
+        // know which. Re-index everything.
+        _accounts_index_reset(accounts);
+        return;
+    }
+    // Without collisions, all indexed accounts are in `names`.
+    if (account->name_key == NULL ||
+            g_hash_table_lookup(accounts->names, account->name_key) != account) {
+        // Not indexed yet, or deleted.
+        return;
+    }
+    g_hash_table_remove(accounts->names, account->name_key);
+    _accounts_unindex_key(accounts->numbers, account->account_number, account);
+    _accounts_unindex_key(accounts->references, account->reference, account);
+    accounts->unindexed = account;
+}
+
+void
+accounts_reindex(AccountList *accounts, Account *account)
+{
+    if (accounts->unindexed != account) {
+        return;
+    }
+    accounts->unindexed = NULL;
+    if (account->name_key == NULL) {
+        return;
+    }
+    _accounts_index(accounts, account);
+    if (accounts->collisions > 0) {
+        // `account` might come before the account that has its key.
+        _accounts_index_reset(accounts);
+    }
+}
+
 bool
 accounts_undelete(AccountList *accounts, Account *target)
 {
@@ -144,7 +337,7 @@ accounts_undelete(AccountList *accounts, Account *target)
 }
 
 Account *
-accounts_find_by_name(const AccountList *accounts, const char *name)
+accounts_find_by_name(AccountList *accounts, const char *name)
 {
     if (name == NULL) {
         return NULL;
@@ -160,16 +353,10 @@ accounts_find_by_name(const AccountList *accounts, const char *name)
     gchar *casefold = g_utf8_casefold(trimmed, -1);
     gchar *key = g_utf8_collate_key(casefold, -1);
     g_free(casefold);
-    for (int i=0; i<accounts->count; i++) {
-        Account *a = accounts->accounts[i];
-        if (strcmp(key, a->name_key) == 0) {
-            res = a;
-            break;
-        }
-        if (a->account_number != NULL && strcmp(trimmed, a->account_number) == 0) {
-            res = a;
-            break;
-        }
+    _accounts_ensure_indexed(accounts);
+    res = g_hash_table_lookup(accounts->names, key);
+    if (res == NULL && trimmed[0] != '\0') {
+        res = g_hash_table_lookup(accounts->numbers, trimmed);
     }
     if (dst != NULL) {
         free(dst);
@@ -179,16 +366,11 @@ accounts_find_by_name(const AccountList *accounts, const char *name)
 }
 
 Account*
-accounts_find_by_reference(const AccountList *accounts, const char *reference)
+accounts_find_by_reference(AccountList *accounts, const char *reference)
 {
     if ((reference == NULL) || (strlen(reference) == 0)) {
         return NULL;
     }
-    for (int i=0; i<accounts->count; i++) {
-        Account *a = accounts->accounts[i];
-        if (strcmp(reference, a->reference) == 0) {
-            return a;
-        }
-    }
-    return NULL;
+    _accounts_ensure_indexed(accounts);
+    return g_hash_table_lookup(accounts->references, reference);
 }
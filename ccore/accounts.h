@@ -4,13 +4,41 @@
 #include "account.h"
 #include "entry.h"
 
-typedef struct {
+/* A list of accounts, indexed by name, account number and reference.
+ *
+ * Our indexes are built lazily: accounts_create() returns an account that
+ * doesn't have its name yet, so accounts are indexed the next time we need to
+ * find one. Our indexes point to the strings of our accounts, so changes to
+ * the name, number or reference of an account happening outside of
+ * accounts_rename() have to be wrapped between accounts_unindex() and
+ * accounts_reindex().
+ */
+typedef struct _AccountList {
     Currency *default_currency;
     int count;
     Account **accounts;
-    GHashTable *a2entries;
+    // Entries of each account we ever created (deleted ones included),
+    // indexed by account id.
+    EntryList **id2entries;
+    // Id that the next created account gets. Also the length of `id2entries`.
+    int next_id;
     // Where we put our deleted accounts so that we can undelete them
     GPtrArray *trashcan;
+    // name_key -> Account*
+    GHashTable *names;
+    // account_number -> Account*
+    GHashTable *numbers;
+    // reference -> Account*
+    GHashTable *references;
+    // Number of accounts, at the beginning of `accounts`, that are in our
+    // indexes.
+    int indexed;
+    // Number of indexed accounts that have a key already taken by a preceding
+    // account. As long as there's none, each indexed account is in our
+    // indexes under all its keys and can be updated in place.
+    int collisions;
+    // Account taken out of our indexes by accounts_unindex(). NULL if none.
+    Account *unindexed;
 } AccountList;
 
 void
@@ -26,9 +54,28 @@ accounts_copy(AccountList *dst, const AccountList *src);
 Account*
 accounts_create(AccountList *accounts);
 
+/* Returns the entries of `account`.
+ *
+ * If `account` doesn't come from `accounts`, we return the entries of our
+ * account with the same name. If we have no such account, returns NULL.
+ */
 EntryList*
 accounts_entries_for_account(AccountList *accounts, Account *account);
 
+/* Cooks the entries of all accounts, including deleted ones.
+ *
+ * With `threads` > 1, entry lists are cooked in parallel by that many threads
+ * (the calling one included). Each thread picks the next list that hasn't
+ * been picked yet, biggest ones first, so that threads stay busy even when
+ * lists have very uneven sizes. Entry lists only share rate lookups, which are
+ * thread-safe, but the caller has to make sure that no one touches our
+ * accounts or their txns in the meantime.
+ *
+ * Returns false if any of the lists failed to cook.
+ */
+bool
+accounts_cook(AccountList *accounts, int threads);
+
 bool
 accounts_remove(AccountList *accounts, Account *todelete);
 
@@ -38,16 +85,32 @@ accounts_rename(AccountList *accounts, Account *target, const char *newname);
 bool
 accounts_undelete(AccountList *accounts, Account *torestore);
 
-/* Returns the first account that matches `name`.
+/* Takes `account` out of our indexes before its name, account number or
+ * reference changes.
+ *
+ * Once the change is done, accounts_reindex() puts it back. Other accounts
+ * stay indexed, so this is O(1) unless keys are shared between accounts, in
+ * which case we re-index everything on our next lookup.
+ */
+void
+accounts_unindex(AccountList *accounts, Account *account);
+
+void
+accounts_reindex(AccountList *accounts, Account *account);
+
+/* Returns the account that matches `name`.
  *
- * If `name` matches the account's `account_number`, we consider this a match.
+ * Names are compared case-insensitively. If no account has that name, we look
+ * for an account with `name` as its `account_number`. A name match thus wins
+ * over a number match, wherever the accounts are in the list. Among accounts
+ * matching the same way, the first one wins.
  *
  * NOTE: can return a deleted account
  */
 Account*
-accounts_find_by_name(const AccountList *accounts, const char *name);
+accounts_find_by_name(AccountList *accounts, const char *name);
 
 // Doesn't search in deleted accounts
 Account*
-accounts_find_by_reference(const AccountList *accounts, const char *reference);
+accounts_find_by_reference(AccountList *accounts, const char *reference);
 
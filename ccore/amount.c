@@ -8,8 +8,29 @@
 
 static Amount g_zero = {0, NULL};
 
+// A rate lookup needed by amount_convert_many()
+typedef struct {
+    Currency *currency;
+    time_t date;
+    int index;
+} RateLookup;
+
 /* Private */
 
+static int
+ratelookup_cmp(const void *a, const void *b)
+{
+    const RateLookup *l1 = a;
+    const RateLookup *l2 = b;
+    if (l1->currency != l2->currency) {
+        return l1->currency < l2->currency ? -1 : 1;
+    }
+    if (l1->date != l2->date) {
+        return l1->date < l2->date ? -1 : 1;
+    }
+    return l1->index - l2->index;
+}
+
 static int
 group_intfmt(char *dest, uint64_t val, char grouping_sep) {
     int64_t left;
@@ -660,3 +681,48 @@ amount_convert(Amount *dest, const Amount *src, time_t date)
         dest->currency->exponent);
     return true;
 }
+
+bool
+amount_convert_many(
+    Amount *dest,
+    const Amount *src,
+    const time_t *dates,
+    int count,
+    Currency *currency)
+{
+    RateLookup *lookups = malloc(sizeof(RateLookup) * count);
+    if (count && lookups == NULL) {
+        return false;
+    }
+    int lookupcount = 0;
+    for (int i=0; i<count; i++) {
+        if (src[i].currency == currency || !src[i].val) {
+            dest[i].val = src[i].val;
+            dest[i].currency = currency;
+        } else {
+            lookups[lookupcount].currency = src[i].currency;
+            lookups[lookupcount].date = dates[i];
+            lookups[lookupcount].index = i;
+            lookupcount++;
+        }
+    }
+    qsort(lookups, lookupcount, sizeof(RateLookup), ratelookup_cmp);
+    double rate = 0;
+    for (int i=0; i<lookupcount; i++) {
+        RateLookup *l = &lookups[i];
+        if (i == 0 || l->currency != l[-1].currency || l->date != l[-1].date) {
+            if (currency_getrate(l->date, l->currency, currency, &rate) != CURRENCY_OK) {
+                free(lookups);
+                return false;
+            }
+        }
+        const Amount *a = &src[l->index];
+        dest[l->index].val = amount_slide(
+            a->val * rate,
+            l->currency->exponent,
+            currency->exponent);
+        dest[l->index].currency = currency;
+    }
+    free(lookups);
+    return true;
+}
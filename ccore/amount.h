@@ -176,3 +176,18 @@ amount_parse(
  */
 bool
 amount_convert(Amount *dest, const Amount *src, time_t date);
+
+/* Convert `count` amounts from `src` into `dest`, `src[i]` at `dates[i]`.
+ *
+ * All `dest` amounts end up with `currency`. Rates are resolved once per
+ * distinct (source currency, date) pair rather than once per amount, which
+ * makes this much faster than calling `amount_convert()` in a loop when many
+ * amounts share the same dates. `dest` and `src` can be the same array.
+ */
+bool
+amount_convert_many(
+    Amount *dest,
+    const Amount *src,
+    const time_t *dates,
+    int count,
+    Currency *currency);
@@ -0,0 +1,208 @@
+#include <stdlib.h>
+#include <string.h>
+#include "completion.h"
+#include "util.h"
+
+/* Private */
+static bool
+_is_diacritic(gunichar c)
+{
+    // Same ranges as in core.model.sort.sort_string()
+    return (c >= 0x300 && c <= 0x36f) || (c >= 0x1dc0 && c <= 0x1dff);
+}
+
+// Returns a newly allocated, casefolded and diacritics-free version of `s`.
+static char*
+_completion_key(const char *s)
+{
+    gchar *decomposed = g_utf8_normalize(s, -1, G_NORMALIZE_NFD);
+    if (decomposed == NULL) {
+        // invalid UTF-8
+        decomposed = g_strdup(s);
+    }
+    gchar *res = g_utf8_casefold(decomposed, -1);
+    g_free(decomposed);
+    char *dst = res;
+    char *src = res;
+    while (*src != '\0') {
+        char *next = g_utf8_next_char(src);
+        if (!_is_diacritic(g_utf8_get_char(src))) {
+            memmove(dst, src, next - src);
+            dst += next - src;
+        }
+        src = next;
+    }
+    *dst = '\0';
+    return res;
+}
+
+static void
+_completion_free(gpointer data)
+{
+    Completion *c = data;
+    free(c->value);
+    g_free(c->key);
+    free(c);
+}
+
+/* Sorts by key, then value. A NULL value sorts before all values of its key,
+ * which is how we find the first completion that can match a prefix.
+ */
+static gint
+_completion_cmp(gconstpointer a, gconstpointer b, gpointer data)
+{
+    const Completion *c1 = a;
+    const Completion *c2 = b;
+    int res = strcmp(c1->key, c2->key);
+    if (res != 0) {
+        return res;
+    }
+    if (c1->value == NULL) {
+        return c2->value == NULL ? 0 : -1;
+    }
+    if (c2->value == NULL) {
+        return 1;
+    }
+    return strcmp(c1->value, c2->value);
+}
+
+static int
+_completion_cmp_rank(const void *a, const void *b)
+{
+    const Completion *c1 = *((Completion **)a);
+    const Completion *c2 = *((Completion **)b);
+    if (c1->rank.major != c2->rank.major) {
+        return c1->rank.major < c2->rank.major ? -1 : 1;
+    }
+    if (c1->rank.minor != c2->rank.minor) {
+        return c1->rank.minor < c2->rank.minor ? -1 : 1;
+    }
+    return 0;
+}
+
+// Adds `stripped`, which we take ownership of, or changes its rank if `update`.
+static bool
+_completion_insert(
+    CompletionIndex *index,
+    char *stripped,
+    CompletionRank rank,
+    bool update)
+{
+    GSequenceIter *iter = g_hash_table_lookup(index->values, stripped);
+    if (iter != NULL) {
+        if (update) {
+            ((Completion *)g_sequence_get(iter))->rank = rank;
+        }
+        free(stripped);
+        return false;
+    }
+    Completion *c = malloc(sizeof(Completion));
+    c->value = stripped;
+    c->key = _completion_key(stripped);
+    c->rank = rank;
+    iter = g_sequence_insert_sorted(index->items, c, _completion_cmp, NULL);
+    g_hash_table_insert(index->values, c->value, iter);
+    index->count++;
+    return true;
+}
+
+/* Public */
+void
+completion_init(CompletionIndex *index)
+{
+    index->count = 0;
+    index->items = g_sequence_new(_completion_free);
+    index->values = g_hash_table_new(g_str_hash, g_str_equal);
+    index->added = 0;
+}
+
+void
+completion_deinit(CompletionIndex *index)
+{
+    // `values` keys belong to our items.
+    g_hash_table_destroy(index->values);
+    g_sequence_free(index->items);
+}
+
+bool
+completion_add(CompletionIndex *index, const char *candidate)
+{
+    char *stripped = strstripped(candidate);
+    if (stripped == NULL) {
+        return false;
+    }
+    CompletionRank rank = {0, index->added};
+    if (!_completion_insert(index, stripped, rank, false)) {
+        return false;
+    }
+    index->added++;
+    return true;
+}
+
+const char**
+completion_find(CompletionIndex *index, const char *prefix)
+{
+    Completion probe = {NULL, _completion_key(prefix), {0, 0}};
+    int keylen = strlen(probe.key);
+    // Keys starting with our key are contiguous and start at the first key
+    // that is >= it.
+    GSequenceIter *first = g_sequence_search(
+        index->items, &probe, _completion_cmp, NULL);
+    int count = 0;
+    GSequenceIter *iter = first;
+    while (!g_sequence_iter_is_end(iter)) {
+        Completion *c = g_sequence_get(iter);
+        if (strncmp(c->key, probe.key, keylen) != 0) {
+            break;
+        }
+        count++;
+        iter = g_sequence_iter_next(iter);
+    }
+    g_free(probe.key);
+    Completion **found = malloc(sizeof(Completion*) * (count + 1));
+    iter = first;
+    for (int i=0; i<count; i++) {
+        found[i] = g_sequence_get(iter);
+        iter = g_sequence_iter_next(iter);
+    }
+    qsort(found, count, sizeof(Completion*), _completion_cmp_rank);
+    // We reuse `found` for our results.
+    const char **res = (const char **)found;
+    for (int i=0; i<count; i++) {
+        res[i] = found[i]->value;
+    }
+    res[count] = NULL;
+    return res;
+}
+
+bool
+completion_remove(CompletionIndex *index, const char *candidate)
+{
+    char *stripped = strstripped(candidate);
+    if (stripped == NULL) {
+        return false;
+    }
+    GSequenceIter *iter = g_hash_table_lookup(index->values, stripped);
+    free(stripped);
+    if (iter == NULL) {
+        return false;
+    }
+    g_hash_table_remove(
+        index->values, ((Completion *)g_sequence_get(iter))->value);
+    g_sequence_remove(iter);
+    index->count--;
+    return true;
+}
+
+bool
+completion_set(
+    CompletionIndex *index,
+    const char *candidate,
+    CompletionRank rank)
+{
+    char *stripped = strstripped(candidate);
+    if (stripped == NULL) {
+        return false;
+    }
+    return _completion_insert(index, stripped, rank, true);
+}
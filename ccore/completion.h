@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <glib.h>
+
+/* Likelihood of a candidate. Lower is more likely, compared on `major`, then
+ * on `minor`.
+ */
+typedef struct {
+    int64_t major;
+    int64_t minor;
+} CompletionRank;
+
+/* Completion candidates, indexed for fast prefix lookups.
+ *
+ * Candidates can be added and removed at any time, each in O(log n). Lookups
+ * are case and diacritics insensitive: "e" matches "Électrique".
+ */
+typedef struct {
+    // Stripped candidate, as it will be returned.
+    char *value;
+    // Normalized (casefolded, without diacritics) version of `value`.
+    char *key;
+    CompletionRank rank;
+} Completion;
+
+typedef struct {
+    int count;
+    // Completion*, sorted by (key, value).
+    GSequence *items;
+    // value -> GSequenceIter* of `items`. Also ignores duplicates.
+    GHashTable *values;
+    // Number of completion_add() calls so far. Gives their rank.
+    int64_t added;
+} CompletionIndex;
+
+void
+completion_init(CompletionIndex *index);
+
+void
+completion_deinit(CompletionIndex *index);
+
+/* Adds `candidate` as less likely than all previously added candidates.
+ *
+ * Leading and trailing spaces are stripped. Empty candidates and candidates we
+ * already have are ignored.
+ *
+ * Returns true if the candidate was added.
+ */
+bool
+completion_add(CompletionIndex *index, const char *candidate);
+
+/* Returns a NULL-terminated list of candidates that start with `prefix`, most
+ * likely first.
+ *
+ * Strings in the list belong to `index` and are valid until its next
+ * modification. The list itself must be freed with free().
+ */
+const char**
+completion_find(CompletionIndex *index, const char *prefix);
+
+/* Removes `candidate`, which is stripped like in completion_add().
+ *
+ * Returns false if we didn't have it.
+ */
+bool
+completion_remove(CompletionIndex *index, const char *candidate);
+
+/* Same as completion_add(), but with an explicit rank.
+ *
+ * If we already have `candidate`, its rank is changed.
+ */
+bool
+completion_set(
+    CompletionIndex *index,
+    const char *candidate,
+    CompletionRank rank);
@@ -5,14 +5,19 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <sqlite3.h>
 #include <time.h>
+#include <glib.h>
 #include "currency.h"
+#include "util.h"
 
 #define CURRENCY_REGISTRY_BLOCK 100
+#define CURRENCY_RATES_BLOCK 64
 #define DATE_LEN 8
 #define MAX_SQL_LEN 512
 #define SQL_RES_LEN 512
+#define SECS_PER_DAY 86400
 
 static sqlite3 *g_db = NULL;
 // Currencies are allocated in block. Whether a "slot" is registered is
@@ -20,6 +25,17 @@ static sqlite3 *g_db = NULL;
 static Currency *g_currencies = NULL;
 static unsigned int g_currencies_count = 0;
 static unsigned int g_currencies_max = 0;
+// Open-addressing hash table mapping packed codes (see code2key()) to
+// `g_currencies` indexes, offset by one so that 0 means "empty slot". We store
+// indexes rather than pointers so that the table survives reallocs of
+// `g_currencies`. Its size is a power of 2, at least twice `g_currencies_max`.
+static unsigned int *g_currency_index = NULL;
+static unsigned int g_currency_index_size = 0;
+// Protects the in-memory rates of all currencies. Rate lookups can happen
+// from many threads at once (see accounts_cook()), but loading or changing
+// rates needs exclusive access. Registering currencies and global init/deinit
+// aren't protected: they're not supposed to happen while we're cooking.
+static GRWLock g_rates_lock;
 
 // Private
 
@@ -29,37 +45,150 @@ date2str(char *s, const time_t date)
     return strftime(s, DATE_LEN + 1, "%Y%m%d", gmtime(&date));
 }
 
+// Number of days since epoch for the UTC day of `date`. This is the same day
+// as the one date2str() would output.
+static int
+date2day(time_t date)
+{
+    time_t day = date / SECS_PER_DAY;
+    if (date % SECS_PER_DAY < 0) {
+        day--;
+    }
+    return (int)day;
+}
+
+// Parses a "%Y%m%d" string into a number of days since epoch. Returns false
+// if `s` isn't a valid date string.
+static bool
+str2day(const char *s, int *day)
+{
+    int y, m, d;
+
+    if (s == NULL || strlen(s) != DATE_LEN) {
+        return false;
+    }
+    if (sscanf(s, "%4d%2d%2d", &y, &m, &d) != 3) {
+        return false;
+    }
+    *day = days_from_civil(y, m, d);
+    return true;
+}
+
+// Parses a "%Y%m%d" string into the time_t of that UTC day, like our dates.
+// Returns 0 if `s` isn't a valid date string.
 static time_t
 str2date(const char *s)
 {
-    struct tm date = {0};
-    if (strptime(s, "%Y%m%d", &date) == NULL) {
+    int day;
+    if (!str2day(s, &day)) {
         return 0;
     }
-    return mktime(&date);
+    return (time_t)day * SECS_PER_DAY;
+}
+
+/* Returns the index of the first rate in `currency` with a day that is
+ * greater or equal to `day`. Returns `rates_count` if there's none.
+ */
+static unsigned int
+rates_find(const Currency *currency, int day)
+{
+    unsigned int low = 0;
+    unsigned int high = currency->rates_count;
+    while (low < high) {
+        unsigned int mid = low + (high - low) / 2;
+        if (currency->rates[mid].day < day) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
 }
 
+// Inserts, or replaces, the rate at `day`, keeping the rates sorted.
 static bool
-sqlite_getsingle_double(const char *sql, double *result)
+rates_set(Currency *currency, int day, double rate)
+{
+    unsigned int index = rates_find(currency, day);
+    if (index < currency->rates_count && currency->rates[index].day == day) {
+        currency->rates[index].rate = rate;
+        return true;
+    }
+    if (currency->rates_count == currency->rates_max) {
+        unsigned int newmax = currency->rates_max ?
+            currency->rates_max * 2 : CURRENCY_RATES_BLOCK;
+        CurrencyRate *rates = realloc(
+            currency->rates, sizeof(CurrencyRate) * newmax);
+        if (rates == NULL) {
+            return false;
+        }
+        currency->rates = rates;
+        currency->rates_max = newmax;
+    }
+    if (index < currency->rates_count) {
+        memmove(
+            &currency->rates[index+1],
+            &currency->rates[index],
+            sizeof(CurrencyRate) * (currency->rates_count - index));
+    }
+    currency->rates[index].day = day;
+    currency->rates[index].rate = rate;
+    currency->rates_count++;
+    return true;
+}
+
+// Forget about our in-memory rates. They'll be reloaded on next lookup.
+static void
+rates_flush(Currency *currency)
+{
+    free(currency->rates);
+    currency->rates = NULL;
+    currency->rates_count = 0;
+    currency->rates_max = 0;
+    currency->rates_loaded = false;
+}
+
+/* Loads all rates of `currency` from the DB, if not already done.
+ *
+ * Rows come in date order, so the in-memory array is built by appending.
+ */
+static bool
+rates_load(Currency *currency)
 {
     sqlite3_stmt *stmt;
     int rc;
 
-    rc = sqlite3_prepare_v2(g_db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return false;
+    if (currency->rates_loaded) {
+        return true;
     }
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_ROW) {
-        sqlite3_finalize(stmt);
+    if (g_db == NULL) {
         return false;
     }
-    if (sqlite3_column_type(stmt, 0) != SQLITE_FLOAT) {
-        sqlite3_finalize(stmt);
+    rc = sqlite3_prepare_v2(
+        g_db,
+        "select date, rate from rates where currency = ? order by date",
+        -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
         return false;
     }
-    *result = sqlite3_column_double(stmt, 0);
+    sqlite3_bind_text(stmt, 1, currency->code, -1, SQLITE_STATIC);
+    currency->rates_count = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        int day;
+        if (sqlite3_column_type(stmt, 1) != SQLITE_FLOAT) {
+            continue;
+        }
+        if (!str2day((const char *)sqlite3_column_text(stmt, 0), &day)) {
+            continue;
+        }
+        if (!rates_set(currency, day, sqlite3_column_double(stmt, 1))) {
+            sqlite3_finalize(stmt);
+            rates_flush(currency);
+            return false;
+        }
+    }
     sqlite3_finalize(stmt);
+    currency->rates_loaded = true;
     return true;
 }
 
@@ -89,15 +218,14 @@ sqlite_getsingle_text(const char *sql, char *result)
     return true;
 }
 
+/* Returns the CAD value of `currency` at `date`.
+ *
+ * We use the rate of the nearest day that is smaller or equal to `date`. If
+ * there is none, we use the rate of the nearest day after `date`.
+ */
 static CurrencyResult
 seek_value_in_CAD(time_t date, Currency *currency, double *result)
 {
-    char strdate[DATE_LEN + 1];
-    char sql[MAX_SQL_LEN + 1];
-    char *sqlfmt = "select rate from rates "
-        "where date %s '%s' and currency = '%s' "
-        "order by date %s limit 1";
-    double rate;
 
     if (strncmp(currency->code, "CAD", CURRENCY_CODE_MAXLEN) == 0) {
         *result = 1;
@@ -111,20 +239,85 @@ seek_value_in_CAD(time_t date, Currency *currency, double *result)
         *result = currency->latest_rate;
         return CURRENCY_OK;
     }
-    date2str(strdate, date);
-    snprintf(
-        sql, MAX_SQL_LEN, sqlfmt,
-        "<=", strdate, currency->code, "desc");
-    if (!sqlite_getsingle_double(sql, &rate)) {
-        snprintf(
-            sql, MAX_SQL_LEN, sqlfmt,
-            ">=", strdate, currency->code, "");
-        if (!sqlite_getsingle_double(sql, &rate)) {
+    g_rw_lock_reader_lock(&g_rates_lock);
+    if (!currency->rates_loaded) {
+        g_rw_lock_reader_unlock(&g_rates_lock);
+        g_rw_lock_writer_lock(&g_rates_lock);
+        bool loaded = rates_load(currency);
+        g_rw_lock_writer_unlock(&g_rates_lock);
+        if (!loaded) {
             return CURRENCY_NORESULT;
         }
+        g_rw_lock_reader_lock(&g_rates_lock);
+    }
+    CurrencyResult res = CURRENCY_NORESULT;
+    if (currency->rates_count) {
+        // index of the first rate that is *after* date
+        unsigned int index = rates_find(currency, date2day(date) + 1);
+        if (index > 0) {
+            index--;
+        }
+        *result = currency->rates[index].rate;
+        res = CURRENCY_OK;
     }
-    *result = rate;
-    return CURRENCY_OK;
+    g_rw_lock_reader_unlock(&g_rates_lock);
+    return res;
+}
+
+/* Packs the first CURRENCY_CODE_MAXLEN chars of `code` in an integer.
+ *
+ * Two codes have the same key exactly when the previous
+ * strncmp(a, b, CURRENCY_CODE_MAXLEN) lookup considered them equal.
+ */
+static uint32_t
+code2key(const char *code)
+{
+    uint32_t key = 0;
+    for (int i=0; i<CURRENCY_CODE_MAXLEN && code[i]; i++) {
+        key |= (uint32_t)(unsigned char)code[i] << (i * 8);
+    }
+    return key;
+}
+
+static unsigned int
+index_slot(uint32_t key)
+{
+    // Fibonacci hashing, then linear probing in callers.
+    return (key * 2654435761u) & (g_currency_index_size - 1);
+}
+
+static void
+index_add(unsigned int i)
+{
+    unsigned int slot = index_slot(code2key(g_currencies[i].code));
+    while (g_currency_index[slot]) {
+        slot = (slot + 1) & (g_currency_index_size - 1);
+    }
+    g_currency_index[slot] = i + 1;
+}
+
+// Reallocates the index to fit `g_currencies_max` and re-adds all registered
+// currencies to it.
+static bool
+index_rebuild(void)
+{
+    unsigned int size = 16;
+    while (size < g_currencies_max * 2) {
+        size *= 2;
+    }
+    if (size != g_currency_index_size) {
+        unsigned int *index = realloc(g_currency_index, size * sizeof(unsigned int));
+        if (index == NULL) {
+            return false;
+        }
+        g_currency_index = index;
+        g_currency_index_size = size;
+    }
+    memset(g_currency_index, 0, g_currency_index_size * sizeof(unsigned int));
+    for (unsigned int i=0; i<g_currencies_count; i++) {
+        index_add(i);
+    }
+    return true;
 }
 
 // Public
@@ -144,6 +337,10 @@ currency_global_init(char *dbpath)
         sqlite3_close(g_db);
         g_db = NULL;
     }
+    // Our in-memory rates come from the old DB.
+    for (unsigned int i=0; i<g_currencies_count; i++) {
+        rates_flush(&g_currencies[i]);
+    }
     res = sqlite3_open(dbpath, &g_db);
     if (res) {
         sqlite3_close(g_db);
@@ -173,8 +370,10 @@ currency_global_reset_currencies(void)
         // list
         for (unsigned int i=3; i<g_currencies_count; i++) {
             g_currencies[i].code[0] = '\0';
+            rates_flush(&g_currencies[i]);
         }
         g_currencies_count = 3;
+        index_rebuild();
         return CURRENCY_OK;
     }
     g_currencies = calloc(CURRENCY_REGISTRY_BLOCK, sizeof(Currency));
@@ -182,6 +381,9 @@ currency_global_reset_currencies(void)
         return CURRENCY_ERROR;
     }
     g_currencies_max = CURRENCY_REGISTRY_BLOCK;
+    if (!index_rebuild()) {
+        return CURRENCY_ERROR;
+    }
     // Register our 3 base currencies
     currency_register(
         "USD",
@@ -215,8 +417,17 @@ currency_global_deinit(void)
         g_db = NULL;
     }
     if (g_currencies != NULL) {
+        for (unsigned int i=0; i<g_currencies_count; i++) {
+            rates_flush(&g_currencies[i]);
+        }
         free(g_currencies);
+        g_currencies = NULL;
+        g_currencies_count = 0;
+        g_currencies_max = 0;
     }
+    free(g_currency_index);
+    g_currency_index = NULL;
+    g_currency_index_size = 0;
 }
 
 Currency*
@@ -248,6 +459,9 @@ currency_register(
         for (unsigned int i=g_currencies_count; i<g_currencies_max; i++) {
             g_currencies[i].code[0] = '\0';
         }
+        if (!index_rebuild()) {
+            return NULL;
+        }
     }
     cur = &g_currencies[g_currencies_count];
     strncpy(cur->code, code, CURRENCY_CODE_MAXLEN);
@@ -256,6 +470,11 @@ currency_register(
     cur->start_rate = start_rate;
     cur->stop_date = stop_date;
     cur->latest_rate = latest_rate;
+    cur->rates = NULL;
+    cur->rates_count = 0;
+    cur->rates_max = 0;
+    cur->rates_loaded = false;
+    index_add(g_currencies_count);
     g_currencies_count++;
     return cur;
 }
@@ -271,10 +490,14 @@ currency_get(const char *code)
         return NULL;
     }
 
-    for (unsigned int i=0; i<g_currencies_count; i++) {
-        if (strncmp(code, g_currencies[i].code, CURRENCY_CODE_MAXLEN) == 0) {
-            return &g_currencies[i];
+    uint32_t key = code2key(code);
+    unsigned int slot = index_slot(key);
+    while (g_currency_index[slot]) {
+        Currency *cur = &g_currencies[g_currency_index[slot] - 1];
+        if (code2key(cur->code) == key) {
+            return cur;
         }
+        slot = (slot + 1) & (g_currency_index_size - 1);
     }
     return NULL;
 }
@@ -308,17 +531,62 @@ currency_getrate(time_t date, Currency *c1, Currency *c2, double *result)
 
 void
 currency_set_CAD_value(time_t date, Currency *currency, double value)
+{
+    currency_set_CAD_values(currency, &date, &value, 1);
+}
+
+CurrencyResult
+currency_set_CAD_values(
+    Currency *currency,
+    const time_t *dates,
+    const double *values,
+    int count)
 {
     char strdate[DATE_LEN + 1];
-    char sql[MAX_SQL_LEN + 1];
+    sqlite3_stmt *stmt;
+    int rc;
 
-    date2str(strdate, date);
-    snprintf(
-        sql, MAX_SQL_LEN,
-        "replace into rates(date, currency, rate) values('%s', '%s', %0.6f)",
-        strdate, currency->code, value);
-    sqlite3_exec(g_db, sql, NULL, NULL, NULL);
-    sqlite3_exec(g_db, "commit", NULL, NULL, NULL);
+    if (g_db == NULL) {
+        return CURRENCY_ERROR;
+    }
+    rc = sqlite3_prepare_v2(
+        g_db,
+        "replace into rates(date, currency, rate) values(?, ?, ?)",
+        -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        return CURRENCY_ERROR;
+    }
+    g_rw_lock_writer_lock(&g_rates_lock);
+    sqlite3_exec(g_db, "begin", NULL, NULL, NULL);
+    sqlite3_bind_text(stmt, 2, currency->code, -1, SQLITE_STATIC);
+    for (int i=0; i<count; i++) {
+        date2str(strdate, dates[i]);
+        sqlite3_bind_text(stmt, 1, strdate, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_double(stmt, 3, values[i]);
+        rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (rc != SQLITE_DONE) {
+            sqlite3_finalize(stmt);
+            sqlite3_exec(g_db, "rollback", NULL, NULL, NULL);
+            // Some of our in-memory rates might not be in the DB anymore.
+            rates_flush(currency);
+            g_rw_lock_writer_unlock(&g_rates_lock);
+            return CURRENCY_ERROR;
+        }
+        if (currency->rates_loaded) {
+            if (!rates_set(currency, date2day(dates[i]), values[i])) {
+                rates_flush(currency);
+            }
+        }
+    }
+    sqlite3_finalize(stmt);
+    if (sqlite3_exec(g_db, "commit", NULL, NULL, NULL) != SQLITE_OK) {
+        rates_flush(currency);
+        g_rw_lock_writer_unlock(&g_rates_lock);
+        return CURRENCY_ERROR;
+    }
+    g_rw_lock_writer_unlock(&g_rates_lock);
+    return CURRENCY_OK;
 }
 
 bool
@@ -5,6 +5,12 @@
 #define CURRENCY_CODE_MAXLEN 4
 #define CURRENCY_MAX_EXPONENT 10
 
+/* A CAD value at a specific day. `day` is a number of days since epoch. */
+typedef struct {
+    int day;
+    double rate;
+} CurrencyRate;
+
 typedef struct {
     char code[CURRENCY_CODE_MAXLEN+1];
     unsigned int exponent;
@@ -12,6 +18,13 @@ typedef struct {
     double start_rate;
     time_t stop_date;
     double latest_rate;
+    // In-memory copy of this currency's rows in the `rates` table, sorted by
+    // day. Lazily loaded on the first rate lookup and then kept in sync by
+    // currency_set_CAD_value().
+    CurrencyRate *rates;
+    unsigned int rates_count;
+    unsigned int rates_max;
+    bool rates_loaded;
 } Currency;
 
 typedef enum {
@@ -47,5 +60,18 @@ currency_getrate(time_t date, Currency *c1, Currency *c2, double *result);
 void
 currency_set_CAD_value(time_t date, Currency *currency, double value);
 
+/* Sets `count` CAD values for `currency` in a single DB transaction.
+ *
+ * `dates` and `values` are parallel arrays. This is much faster than calling
+ * currency_set_CAD_value() repeatedly when we have many rates to save: we
+ * only prepare our statement once and only commit once.
+ */
+CurrencyResult
+currency_set_CAD_values(
+    Currency *currency,
+    const time_t *dates,
+    const double *values,
+    int count);
+
 bool
 currency_daterange(Currency *currency, time_t *start, time_t *stop);
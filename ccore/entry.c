@@ -1,14 +1,19 @@
 #include <stdlib.h>
 #include "entry.h"
 
+#define ENTRIES_MIN_CAPACITY 64
+#define ENTRIES_SLAB_MIN 64
+
 void
 entry_init(Entry *entry, Split *split, Transaction *txn)
 {
-    entry->split = split;
     entry->txn = txn;
+    entry->splitindex = split->index;
     amount_copy(&entry->balance, amount_zero());
     amount_copy(&entry->reconciled_balance, amount_zero());
     amount_copy(&entry->balance_with_budget, amount_zero());
+    entry->recpos = -1;
+    entry->index = -1;
 }
 
 bool
@@ -17,11 +22,14 @@ entry_amount_set(Entry *entry, const Amount *amount)
     if (entry->txn->splitcount != 2) {
         return false;
     }
+    // Our split might be shared. Follow it to our own copy.
+    transaction_own_splits(entry->txn);
+    Split *split = entry_split(entry);
     Split *other = &entry->txn->splits[0];
-    if (other == entry->split) {
+    if (other == split) {
         other = &entry->txn->splits[1];
     }
-    split_amount_set(entry->split, amount);
+    split_amount_set(split, amount);
     Amount *other_amount = &other->amount;
     bool is_mct = false;
     // Weird rules, but well...
@@ -32,7 +40,7 @@ entry_amount_set(Entry *entry, const Amount *amount)
     if (!same_currency) {
         bool is_asset = false;
         bool other_is_asset = false;
-        Account *a = entry->split->account;
+        Account *a = split->account;
         if (a != NULL) {
             is_asset = account_is_balance_sheet(a);
         }
@@ -47,7 +55,7 @@ entry_amount_set(Entry *entry, const Amount *amount)
 
     if (is_mct) {
         // don't touch other side unless we have a logical imbalance
-        if ((entry->split->amount.val > 0) == (other_amount->val > 0)) {
+        if ((split->amount.val > 0) == (other_amount->val > 0)) {
             Amount a;
             amount_neg(&a, other_amount);
             split_amount_set(other, &a);
@@ -63,11 +71,19 @@ entry_amount_set(Entry *entry, const Amount *amount)
 void
 entry_copy(Entry *dst, const Entry *src)
 {
-    dst->split = src->split;
     dst->txn = src->txn;
+    dst->splitindex = src->splitindex;
     amount_copy(&dst->balance, &src->balance);
     amount_copy(&dst->reconciled_balance, &src->reconciled_balance);
     amount_copy(&dst->balance_with_budget, &src->balance_with_budget);
+    dst->recpos = src->recpos;
+    dst->index = src->index;
+}
+
+Split*
+entry_split(const Entry *entry)
+{
+    return &entry->txn->splits[entry->splitindex];
 }
 
 /* EntryList Private */
@@ -77,8 +93,8 @@ _entry_qsort_cmp(const void *a, const void *b)
     Entry *e1 = *((Entry **)a);
     Entry *e2 = *((Entry **)b);
 
-    time_t date1 = e1->split->reconciliation_date;
-    time_t date2 = e2->split->reconciliation_date;
+    time_t date1 = entry_split(e1)->reconciliation_date;
+    time_t date2 = entry_split(e2)->reconciliation_date;
     if (!date1) {
         date1 = e1->txn->date;
     }
@@ -91,40 +107,313 @@ _entry_qsort_cmp(const void *a, const void *b)
     if (e1->txn->position != e2->txn->position) {
         return e1->txn->position < e2->txn->position ? -1 : 1;
     }
-    if (e1->split->index != e2->split->index) {
-        return e1->split->index < e2->split->index ? -1 : 1;
+    if (e1->splitindex != e2->splitindex) {
+        return e1->splitindex < e2->splitindex ? -1 : 1;
     }
     return 0;
 }
 
+/* Fenwick trees
+ *
+ * Positions are 0-based. Node `i` (1-based) holds the sum of positions
+ * [i - lowbit(i), i - 1].
+ */
 static void
-_entries_maybe_set_last_reconciled(EntryList *entries, Entry *entry)
+_fenwick_add(int64_t *tree, int size, int pos, int64_t delta)
 {
-    if (entry->split->reconciliation_date != 0) {
-        if (entries->last_reconciled == NULL) {
-            entries->last_reconciled = entry;
-        } else {
-            bool replace = false;
-            Entry *old = entries->last_reconciled;
-            if (entry->split->reconciliation_date != old->split->reconciliation_date) {
-                if (entry->split->reconciliation_date > old->split->reconciliation_date) {
-                    replace = true;
-                }
-            } else if (entry->txn->date != old->txn->date) {
-                if (entry->txn->date > old->txn->date) {
-                    replace = true;
-                }
-            } else if (entry->txn->position != old->txn->position) {
-                if (entry->txn->position > old->txn->position) {
-                    replace = true;
-                }
-            } else if (entry->split->index > old->split->index) {
-                replace = true;
-            }
-            if (replace) {
-                entries->last_reconciled = entry;
-            }
+    for (int i=pos+1; i<=size; i+=i&-i) {
+        tree[i-1] += delta;
+    }
+}
+
+// Sum of positions [0, pos]. 0 when pos < 0.
+static int64_t
+_fenwick_sum(const int64_t *tree, int pos)
+{
+    int64_t res = 0;
+    for (int i=pos+1; i>0; i-=i&-i) {
+        res += tree[i-1];
+    }
+    return res;
+}
+
+// Appends `value` at position `size`. Nodes of a tree never depend on
+// positions after theirs, so truncating a tree is only a matter of using a
+// smaller size.
+static void
+_fenwick_append(int64_t *tree, int size, int64_t value)
+{
+    int i = size + 1;
+    tree[size] = value + _fenwick_sum(tree, size - 1) - _fenwick_sum(tree, i - (i&-i) - 1);
+}
+
+// Returns the smallest position with a prefix sum >= `target`. Values in the
+// tree must all be positive. Returns `size` if there's none.
+static int
+_fenwick_find(const int64_t *tree, int size, int64_t target)
+{
+    int step = 1;
+    while (step * 2 <= size) {
+        step *= 2;
+    }
+    int pos = 0;
+    for (; step > 0; step /= 2) {
+        if (pos + step <= size && tree[pos+step-1] < target) {
+            pos += step;
+            target -= tree[pos-1];
+        }
+    }
+    return pos;
+}
+
+static int64_t
+_entries_reconciled_amount(const Entry *entry)
+{
+    const Split *split = entry_split(entry);
+    return split->reconciliation_date != 0 ? split->amount.val : 0;
+}
+
+// Builds a tree from `size` values already placed in `tree`, in O(n).
+static void
+_fenwick_build(int64_t *tree, int size)
+{
+    for (int i=1; i<=size; i++) {
+        int parent = i + (i&-i);
+        if (parent <= size) {
+            tree[parent-1] += tree[i-1];
+        }
+    }
+}
+
+// Sets `last_reconciled` from our reconciled counts.
+static void
+_entries_update_last_reconciled(EntryList *entries)
+{
+    int size = entries->cooked_until;
+    int64_t total = _fenwick_sum(entries->reccounts, size - 1);
+    if (total == 0) {
+        entries->last_reconciled = NULL;
+    } else {
+        int pos = _fenwick_find(entries->reccounts, size, total);
+        entries->last_reconciled = entries->byrec[pos];
+    }
+}
+
+// Appends `entry` at the end of our reconciliation order.
+static void
+_entries_byrec_append(EntryList *entries, Entry *entry, int pos)
+{
+    entry->recpos = pos;
+    entries->byrec[pos] = entry;
+    int64_t amount = _entries_reconciled_amount(entry);
+    _fenwick_append(entries->recsums, pos, amount);
+    _fenwick_append(entries->reccounts, pos, entry_split(entry)->reconciliation_date != 0 ? 1 : 0);
+}
+
+// Rebuilds our trees from the `size` first entries of `byrec`.
+static void
+_entries_byrec_rebuild(EntryList *entries, int size)
+{
+    for (int i=0; i<size; i++) {
+        Entry *entry = entries->byrec[i];
+        entry->recpos = i;
+        entries->recsums[i] = _entries_reconciled_amount(entry);
+        entries->reccounts[i] = entry_split(entry)->reconciliation_date != 0 ? 1 : 0;
+    }
+    _fenwick_build(entries->recsums, size);
+    _fenwick_build(entries->reccounts, size);
+}
+
+static bool
+_entries_byrec_reserve(EntryList *entries, int capacity)
+{
+    if (capacity <= entries->reccapacity) {
+        return true;
+    }
+    Entry **byrec = realloc(entries->byrec, sizeof(Entry*) * capacity);
+    if (byrec == NULL) {
+        return false;
+    }
+    entries->byrec = byrec;
+    int64_t *recsums = realloc(entries->recsums, sizeof(int64_t) * capacity);
+    if (recsums == NULL) {
+        return false;
+    }
+    entries->recsums = recsums;
+    int64_t *reccounts = realloc(entries->reccounts, sizeof(int64_t) * capacity);
+    if (reccounts == NULL) {
+        return false;
+    }
+    entries->reccounts = reccounts;
+    entries->reccapacity = capacity;
+    return true;
+}
+
+/* Returns the slab slot for the entry at `index`, allocating a new slab if
+ * needed. Returns NULL on allocation failure.
+ */
+static Entry*
+_entries_slot(EntryList *entries, int index)
+{
+    int slab = 0;
+    int size = ENTRIES_SLAB_MIN;
+    while (index >= size) {
+        index -= size;
+        size *= 2;
+        slab++;
+    }
+    if (slab >= entries->slabcount) {
+        // Because we fill slots in order, slab == slabcount
+        Entry **slabs = realloc(entries->slabs, sizeof(Entry*) * (slab + 1));
+        if (slabs == NULL) {
+            return NULL;
+        }
+        entries->slabs = slabs;
+        slabs[slab] = malloc(sizeof(Entry) * size);
+        if (slabs[slab] == NULL) {
+            return NULL;
         }
+        entries->slabcount = slab + 1;
+    }
+    return &entries->slabs[slab][index];
+}
+
+/* Grows our balance trees to `capacity`. */
+static bool
+_entries_grow_trees(EntryList *entries, int capacity)
+{
+    int64_t *balancetree = realloc(entries->balancetree, sizeof(int64_t) * capacity);
+    if (balancetree == NULL) {
+        return false;
+    }
+    entries->balancetree = balancetree;
+    int64_t *budgettree = realloc(entries->budgettree, sizeof(int64_t) * capacity);
+    if (budgettree == NULL) {
+        return false;
+    }
+    entries->budgettree = budgettree;
+    return true;
+}
+
+/* Grows our entries pointer array and our columns to `capacity`. Our balance
+ * trees only follow while we're in incremental mode.
+ */
+static bool
+_entries_grow(EntryList *entries, int capacity)
+{
+    Entry **newentries = realloc(entries->entries, sizeof(Entry*) * capacity);
+    if (newentries == NULL) {
+        return false;
+    }
+    entries->entries = newentries;
+    time_t *dates = realloc(entries->dates, sizeof(time_t) * capacity);
+    if (dates == NULL) {
+        return false;
+    }
+    entries->dates = dates;
+    bool *is_budget = realloc(entries->is_budget, sizeof(bool) * capacity);
+    if (is_budget == NULL) {
+        return false;
+    }
+    entries->is_budget = is_budget;
+    int64_t *amounts = realloc(entries->amounts, sizeof(int64_t) * capacity);
+    if (amounts == NULL) {
+        return false;
+    }
+    entries->amounts = amounts;
+    int64_t *balances = realloc(entries->balances, sizeof(int64_t) * capacity);
+    if (balances == NULL) {
+        return false;
+    }
+    entries->balances = balances;
+    int64_t *balances_with_budget = realloc(
+        entries->balances_with_budget, sizeof(int64_t) * capacity);
+    if (balances_with_budget == NULL) {
+        return false;
+    }
+    entries->balances_with_budget = balances_with_budget;
+    if (entries->incremental && !_entries_grow_trees(entries, capacity)) {
+        return false;
+    }
+    entries->capacity = capacity;
+    return true;
+}
+
+/* Running balances of `count` `amounts`, starting from `balance` and
+ * `balance_with_budget`.
+ *
+ * Columns are contiguous and the loops are branch-free so that the compiler
+ * can vectorize the masking pass. The sums themselves carry a dependency from
+ * one row to the next, but they only touch two columns.
+ */
+static void
+_entries_prefix_sums(
+    const int64_t *amounts,
+    const bool *is_budget,
+    int64_t *balances,
+    int64_t *balances_with_budget,
+    int count,
+    int64_t balance,
+    int64_t balance_with_budget)
+{
+    for (int i=0; i<count; i++) {
+        // Budget amounts are masked out of the normal balance.
+        balances[i] = amounts[i] & ((int64_t)is_budget[i] - 1);
+    }
+    for (int i=0; i<count; i++) {
+        balance += balances[i];
+        balances[i] = balance;
+        balance_with_budget += amounts[i];
+        balances_with_budget[i] = balance_with_budget;
+    }
+}
+
+// Amount at `index` as it counts in balances without budget.
+static int64_t
+_entries_normal_amount(const EntryList *entries, int index)
+{
+    return entries->is_budget[index] ? 0 : entries->amounts[index];
+}
+
+/* Switches to incremental balance mode, allocating our trees and building
+ * them from our cooked amounts in O(n). Returns false on allocation failure.
+ */
+static bool
+_entries_enter_incremental(EntryList *entries)
+{
+    if (!_entries_grow_trees(entries, entries->capacity)) {
+        return false;
+    }
+    for (int i=0; i<entries->cooked_until; i++) {
+        entries->balancetree[i] = _entries_normal_amount(entries, i);
+        entries->budgettree[i] = entries->amounts[i];
+    }
+    _fenwick_build(entries->balancetree, entries->cooked_until);
+    _fenwick_build(entries->budgettree, entries->cooked_until);
+    entries->incremental = true;
+    return true;
+}
+
+/* Leaves incremental balance mode. Our balance columns have to be right. */
+static void
+_entries_leave_incremental(EntryList *entries)
+{
+    free(entries->balancetree);
+    entries->balancetree = NULL;
+    free(entries->budgettree);
+    entries->budgettree = NULL;
+    entries->incremental = false;
+}
+
+static int64_t
+_entries_balance_val(const EntryList *entries, int index, bool with_budget)
+{
+    if (entries->incremental) {
+        const int64_t *tree = with_budget ? entries->budgettree : entries->balancetree;
+        return _fenwick_sum(tree, index);
+    } else {
+        return with_budget ?
+            entries->balances_with_budget[index] : entries->balances[index];
     }
 }
 
@@ -133,10 +422,26 @@ void
 entries_init(EntryList *entries, Account *account)
 {
     entries->count = 0;
+    entries->capacity = 0;
     entries->cooked_until = 0;
     entries->entries = NULL;
     entries->last_reconciled = NULL;
     entries->account = account;
+    entries->first_foreign = -1;
+    entries->slabs = NULL;
+    entries->slabcount = 0;
+    entries->byrec = NULL;
+    entries->recsums = NULL;
+    entries->reccounts = NULL;
+    entries->reccapacity = 0;
+    entries->dates = NULL;
+    entries->is_budget = NULL;
+    entries->amounts = NULL;
+    entries->balances = NULL;
+    entries->balances_with_budget = NULL;
+    entries->incremental = false;
+    entries->balancetree = NULL;
+    entries->budgettree = NULL;
 }
 
 void
@@ -148,6 +453,43 @@ entries_deinit(EntryList *entries)
     entries->last_reconciled = NULL;
     entries->account = NULL;
     free(entries->entries);
+    entries->entries = NULL;
+    entries->capacity = 0;
+    for (int i=0; i<entries->slabcount; i++) {
+        free(entries->slabs[i]);
+    }
+    free(entries->slabs);
+    entries->slabs = NULL;
+    entries->slabcount = 0;
+    free(entries->byrec);
+    entries->byrec = NULL;
+    free(entries->recsums);
+    entries->recsums = NULL;
+    free(entries->reccounts);
+    entries->reccounts = NULL;
+    entries->reccapacity = 0;
+    free(entries->dates);
+    entries->dates = NULL;
+    free(entries->is_budget);
+    entries->is_budget = NULL;
+    free(entries->amounts);
+    entries->amounts = NULL;
+    free(entries->balances);
+    entries->balances = NULL;
+    free(entries->balances_with_budget);
+    entries->balances_with_budget = NULL;
+    _entries_leave_incremental(entries);
+}
+
+void
+entries_balance_at(
+    const EntryList *entries,
+    Amount *dst,
+    int index,
+    bool with_budget)
+{
+    dst->currency = entries->account->currency;
+    dst->val = _entries_balance_val(entries, index, with_budget);
 }
 
 bool
@@ -157,11 +499,110 @@ entries_balance_of_reconciled(const EntryList *entries, Amount *dst)
         dst->val = 0;
         return false;
     } else {
-        amount_copy(dst, &entries->last_reconciled->reconciled_balance);
+        entries_reconciled_balance(entries, entries->last_reconciled, dst);
         return true;
     }
 }
 
+void
+entries_reconciled_balance(
+    const EntryList *entries,
+    const Entry *entry,
+    Amount *dst)
+{
+    dst->currency = entries->account->currency;
+    dst->val = _fenwick_sum(entries->recsums, entry->recpos);
+}
+
+// Whether `entry` is cooked and still at its place in reconciliation order.
+static bool
+_entries_byrec_in_place(const EntryList *entries, Entry *entry)
+{
+    int pos = entry->recpos;
+    int size = entries->cooked_until;
+    if (pos < 0 || pos >= size || entries->byrec[pos] != entry) {
+        return false;
+    }
+    if (pos > 0 && _entry_qsort_cmp(&entries->byrec[pos-1], &entry) > 0) {
+        return false;
+    }
+    if (pos < size - 1 && _entry_qsort_cmp(&entry, &entries->byrec[pos+1]) > 0) {
+        return false;
+    }
+    return true;
+}
+
+bool
+entries_reconciliation_changed(EntryList *entries, Entry *entry)
+{
+    if (!_entries_byrec_in_place(entries, entry)) {
+        return false;
+    }
+    int pos = entry->recpos;
+    int size = entries->cooked_until;
+    int64_t oldamount = _fenwick_sum(entries->recsums, pos) - _fenwick_sum(entries->recsums, pos - 1);
+    int64_t oldcount = _fenwick_sum(entries->reccounts, pos) - _fenwick_sum(entries->reccounts, pos - 1);
+    int64_t count = entry_split(entry)->reconciliation_date != 0 ? 1 : 0;
+    _fenwick_add(entries->recsums, size, pos, _entries_reconciled_amount(entry) - oldamount);
+    _fenwick_add(entries->reccounts, size, pos, count - oldcount);
+    _entries_update_last_reconciled(entries);
+    return true;
+}
+
+bool
+entries_transaction_changed(EntryList *entries, const Transaction *txn)
+{
+    int low = entries_find_date(entries, txn->date, false);
+    int high = entries_find_date(entries, txn->date, true);
+    if (high > entries->cooked_until) {
+        high = entries->cooked_until;
+    }
+    bool found = false;
+    Amount amount;
+    amount.currency = entries->account->currency;
+    // Make sure that we can go through with all our entries before we touch
+    // anything.
+    for (int i=low; i<high; i++) {
+        Entry *entry = entries->entries[i];
+        if (entry->txn != txn) {
+            continue;
+        }
+        if (!amount_convert(&amount, &entry_split(entry)->amount, txn->date)) {
+            return false;
+        }
+        if (!_entries_byrec_in_place(entries, entry)) {
+            return false;
+        }
+        found = true;
+    }
+    if (!found) {
+        return false;
+    }
+    if (!entries->incremental && !_entries_enter_incremental(entries)) {
+        return false;
+    }
+    for (int i=low; i<high; i++) {
+        Entry *entry = entries->entries[i];
+        if (entry->txn != txn) {
+            continue;
+        }
+        Split *split = entry_split(entry);
+        amount_convert(&amount, &split->amount, txn->date);
+        if (split->amount.val && split->amount.currency != amount.currency
+                && (entries->first_foreign == -1 || i < entries->first_foreign)) {
+            entries->first_foreign = i;
+        }
+        int64_t delta = amount.val - entries->amounts[i];
+        entries->amounts[i] = amount.val;
+        _fenwick_add(entries->budgettree, entries->cooked_until, i, delta);
+        if (!entries->is_budget[i]) {
+            _fenwick_add(entries->balancetree, entries->cooked_until, i, delta);
+        }
+        entries_reconciliation_changed(entries, entry);
+    }
+    return true;
+}
+
 bool
 entries_balance(const EntryList *entries, Amount *dst, time_t date, bool with_budget)
 {
@@ -182,16 +623,16 @@ entries_balance(const EntryList *entries, Amount *dst, time_t date, bool with_bu
         return false;
     }
     if (index >= 0) {
-        Entry *entry = entries->entries[index];
-        Amount *src = with_budget ? &entry->balance_with_budget : &entry->balance;
+        Amount src;
+        entries_balance_at(entries, &src, index, with_budget);
         if (date > 0) {
-            if (amount_convert(dst, src, date)) {
+            if (amount_convert(dst, &src, date)) {
                 return true;
             } else {
                 return false;
             }
         } else {
-            amount_copy(dst, src);
+            amount_copy(dst, &src);
             return true;
         }
     } else {
@@ -208,23 +649,74 @@ entries_cash_flow(
     time_t to)
 {
     dst->val = 0;
-    for (int i=0; i<entries->count; i++) {
-        Entry *entry = entries->entries[i];
-        Transaction *txn = entry->txn;
-        if (txn->type == TXN_TYPE_BUDGET) {
+    if (!entries->count) {
+        return true;
+    }
+    int low = entries_find_date(entries, from, false);
+    int high = entries_find_date(entries, to, true);
+    if (high <= low) {
+        return true;
+    }
+    if (entries->cooked_until == entries->count && entries->first_foreign == -1
+            && entries->account->currency == dst->currency) {
+        // All our amounts are in our target currency. Our balances are a
+        // prefix sum of our cash flow.
+        dst->val = _entries_balance_val(entries, high-1, false);
+        if (low > 0) {
+            dst->val -= _entries_balance_val(entries, low-1, false);
+        }
+        return true;
+    }
+    // We gather amounts to convert so that we can convert them in bulk. Our
+    // dates are sorted, so only [low, high) is in range.
+    Amount *amounts = malloc(sizeof(Amount) * (high - low));
+    time_t *dates = malloc(sizeof(time_t) * (high - low));
+    if (amounts == NULL || dates == NULL) {
+        free(amounts);
+        free(dates);
+        return false;
+    }
+    int count = 0;
+    for (int i=low; i<high; i++) {
+        if (entries->is_budget[i]) {
             continue;
         }
-        if (txn->date >= from && txn->date <= to) {
-            Amount a;
-            a.currency = dst->currency;
-            Amount *src = &entry->split->amount;
-            if (!amount_convert(&a, src, entry->txn->date)) {
-                return false;
-            }
-            dst->val += a.val;
+        amount_copy(&amounts[count], &entry_split(entries->entries[i])->amount);
+        dates[count] = entries->dates[i];
+        count++;
+    }
+    bool res = amount_convert_many(amounts, amounts, dates, count, dst->currency);
+    if (res) {
+        for (int i=0; i<count; i++) {
+            dst->val += amounts[i].val;
         }
     }
-    return true;
+    free(amounts);
+    free(dates);
+    return res;
+}
+
+int
+entries_balance_steps(
+    const EntryList *entries,
+    Entry **dst,
+    time_t from,
+    time_t to)
+{
+    int low = entries_find_date(entries, from, false);
+    int high = entries_find_date(entries, to, true);
+    if (high > entries->cooked_until) {
+        high = entries->cooked_until;
+    }
+    int count = 0;
+    for (int i=low; i<high; i++) {
+        if (i+1 < high && entries->dates[i+1] == entries->dates[i]) {
+            continue;
+        }
+        dst[count] = entries->entries[i];
+        count++;
+    }
+    return count;
 }
 
 void
@@ -244,18 +736,41 @@ entries_clear(EntryList *entries, time_t fromdate)
             return;
         }
     }
-    for (int i=index; i<entries->count; i++) {
-        free(entries->entries[i]);
+    // Our kept entries are those that were cooked before `index`. Entries
+    // we remove are usually at the end of our reconciliation order, in which
+    // case we simply truncate it. Otherwise, we compact it.
+    int oldsize = entries->cooked_until;
+    int size = index < oldsize ? index : oldsize;
+    bool truncate = true;
+    for (int i=index; i<oldsize; i++) {
+        Entry *entry = entries->entries[i];
+        if (entry->recpos < size) {
+            truncate = false;
+        }
+        entry->recpos = -1;
+    }
+    if (!truncate) {
+        int j = 0;
+        for (int i=0; i<oldsize; i++) {
+            Entry *entry = entries->byrec[i];
+            if (entry->recpos >= 0) {
+                entries->byrec[j] = entry;
+                j++;
+            }
+        }
+        _entries_byrec_rebuild(entries, size);
     }
+    // Our slabs and pointer array are kept for the next entries_create() calls.
     entries->count = index;
-    entries->cooked_until = index;
-    entries->entries = realloc(
-        entries->entries,
-        sizeof(Entry*) * entries->count);
-    entries->last_reconciled = NULL;
-    for (int i=0; i<index; i++) {
-        _entries_maybe_set_last_reconciled(entries, entries->entries[i]);
+    entries->cooked_until = size;
+    if (size == 0 && entries->incremental) {
+        // Everything will be cooked again, our columns will be right.
+        _entries_leave_incremental(entries);
     }
+    if (entries->first_foreign >= index) {
+        entries->first_foreign = -1;
+    }
+    _entries_update_last_reconciled(entries);
 }
 
 bool
@@ -271,6 +786,9 @@ entries_cook(EntryList *entries)
     Amount balance_with_budget;
     Amount reconciled_balance;
 
+    if (!_entries_byrec_reserve(entries, entries->capacity)) {
+        return false;
+    }
     if (!entries_balance(entries, &balance, 0, false)) {
         return false;
     }
@@ -283,50 +801,89 @@ entries_cook(EntryList *entries)
     reconciled_balance.currency = balance.currency;
     amount.currency = balance.currency;
 
-    // Entries in reconciliation order
-    Entry** rel;
-    rel = malloc(sizeof(Entry *) * cookcount);
+    int start = entries->cooked_until;
+    // We convert all our amounts in one go so that rates are only looked up
+    // once per currency and date.
+    Amount *converted = malloc(sizeof(Amount) * cookcount);
+    if (converted == NULL) {
+        return false;
+    }
     for (int i=0; i<cookcount; i++) {
-        Entry *entry = entries->entries[entries->cooked_until+i];
-        Split *split = entry->split;
-        if (!amount_convert(&amount, &split->amount, entry->txn->date)) {
-            return false;
-        }
-        if (entry->txn->type != TXN_TYPE_BUDGET) {
-            balance.val += amount.val;
+        amount_copy(&converted[i], &entry_split(entries->entries[start+i])->amount);
+    }
+    if (!amount_convert_many(
+            converted, converted, &entries->dates[start], cookcount,
+            amount.currency)) {
+        free(converted);
+        return false;
+    }
+    // Entries we cook are added to our reconciliation order, after the
+    // entries we already have.
+    Entry **rel = &entries->byrec[start];
+    for (int i=0; i<cookcount; i++) {
+        Entry *entry = entries->entries[start+i];
+        Split *split = entry_split(entry);
+        if (entries->first_foreign == -1 && split->amount.val
+                && split->amount.currency != amount.currency) {
+            entries->first_foreign = start + i;
         }
+        entries->amounts[start+i] = converted[i].val;
+        rel[i] = entry;
+    }
+    free(converted);
+    _entries_prefix_sums(
+        &entries->amounts[start], &entries->is_budget[start],
+        &entries->balances[start], &entries->balances_with_budget[start],
+        cookcount, balance.val, balance_with_budget.val);
+    for (int i=0; i<cookcount; i++) {
+        Entry *entry = entries->entries[start+i];
+        balance.val = entries->balances[start+i];
         amount_copy(&entry->balance, &balance);
-        balance_with_budget.val += amount.val;
+        balance_with_budget.val = entries->balances_with_budget[start+i];
         amount_copy(&entry->balance_with_budget, &balance_with_budget);
-
-        rel[i] = entry;
+    }
+    if (entries->incremental) {
+        for (int i=start; i<entries->count; i++) {
+            _fenwick_append(entries->balancetree, i, _entries_normal_amount(entries, i));
+            _fenwick_append(entries->budgettree, i, entries->amounts[i]);
+        }
     }
 
     qsort(rel, cookcount, sizeof(Entry *), _entry_qsort_cmp);
 
     for (int i=0; i<cookcount; i++) {
         Entry *entry = rel[i];
-        if (entry->split->reconciliation_date != 0) {
-            reconciled_balance.val += entry->split->amount.val;
-            entries->last_reconciled = entry;
-        }
+        _entries_byrec_append(entries, entry, start + i);
+        reconciled_balance.val += _entries_reconciled_amount(entry);
         amount_copy(&entry->reconciled_balance, &reconciled_balance);
     }
-    free(rel);
     entries->cooked_until = entries->count;
+    _entries_update_last_reconciled(entries);
     return true;
 }
 
 Entry*
 entries_create(EntryList *entries, Split *split, Transaction *txn)
 {
-    entries->count++;
-    entries->entries = realloc(
-        entries->entries,
-        sizeof(Entry*) * entries->count);
-    Entry *res = malloc(sizeof(Entry));
+    if (entries->count == entries->capacity) {
+        int capacity = entries->capacity * 2;
+        if (capacity < ENTRIES_MIN_CAPACITY) {
+            capacity = ENTRIES_MIN_CAPACITY;
+        }
+        if (!_entries_grow(entries, capacity)) {
+            return NULL;
+        }
+    }
+    Entry *res = _entries_slot(entries, entries->count);
+    if (res == NULL) {
+        return NULL;
+    }
     entry_init(res, split, txn);
-    entries->entries[entries->count-1] = res;
+    res->index = entries->count;
+    entries->entries[entries->count] = res;
+    entries->dates[entries->count] = txn->date;
+    entries->is_budget[entries->count] = txn->type == TXN_TYPE_BUDGET;
+    entries->count++;
     return res;
 }
 
@@ -345,8 +902,7 @@ entries_find_date(const EntryList *entries, time_t date, bool equal)
     bool matched_once = false;
     while ((high > low) || ((high == low) && !matched_once)) {
         int mid = ((high - low) / 2) + low;
-        Entry *entry = entries->entries[mid];
-        time_t tdate = entry->txn->date;
+        time_t tdate = entries->dates[mid];
         // operator *look* like they're inverted, but they're not.
         bool match = equal ? tdate > date : tdate >= date;
         if (match) {
@@ -6,24 +6,77 @@
 
 /* An Entry represents a split in the context of an account */
 typedef struct {
-    // The split that we wrap
-    Split *split;
     // The txn it's associated to
     Transaction *txn;
-    // The running total of all preceding entries in the account.
+    // Index in `txn` of the split that we wrap. We don't keep a pointer to
+    // that split: when `txn` stops sharing its splits (see "SHARED SPLITS" in
+    // transaction.h), they move. Use entry_split().
+    unsigned int splitindex;
+    // The running total of all preceding entries in the account. Like
+    // `reconciled_balance`, this is only valid as of the last cook in entries
+    // held by an EntryList: use entries_balance_at() instead.
     Amount balance;
-    // The running total of all preceding *reconciled* entries in the account.
+    // The running total of all preceding *reconciled* entries in the account,
+    // in reconciliation order. In entries held by an EntryList, this is only
+    // valid as of the last cook: use entries_reconciled_balance() instead.
     Amount reconciled_balance;
     // Running balance which includes all Budget spawns.
     Amount balance_with_budget;
+    // Position in the reconciliation order of its EntryList. -1 if not cooked.
+    int recpos;
+    // Position in the `entries` of its EntryList. -1 if not in a list.
+    int index;
 } Entry;
 
 typedef struct {
     int count;
+    // Allocated size of `entries`. Grows geometrically.
+    int capacity;
     int cooked_until;
     Entry **entries;
     Entry *last_reconciled;
     Account *account;
+    // Index of the first cooked entry with an amount in a currency other than
+    // the account's. -1 if there's none. When there's none, the `balance` of
+    // our entries is a prefix sum of their (non-budget) amounts and we can
+    // compute cash flows without going through each entry. After
+    // entries_transaction_changed(), it can point to an entry that isn't
+    // foreign anymore, which only costs us that shortcut.
+    int first_foreign;
+    // Entries are allocated in slabs which are kept around when the list is
+    // cleared and only freed in entries_deinit(). Slab `i` holds
+    // `ENTRIES_SLAB_MIN << i` entries. Because entries are only ever appended,
+    // `entries[i]` always points to the i-th slot of the slab sequence.
+    Entry **slabs;
+    int slabcount;
+    // Cooked entries in reconciliation order: by reconciliation date (or txn
+    // date when not reconciled), then position, then split index.
+    Entry **byrec;
+    // Fenwick trees over `byrec` positions: reconciled split amounts and
+    // reconciled entry counts. They give us reconciled balances in O(log n)
+    // and let us toggle reconciliation without re-cooking.
+    int64_t *recsums;
+    int64_t *reccounts;
+    // Allocated size of `byrec`, `recsums` and `reccounts`.
+    int reccapacity;
+    // Columns, indexed like `entries` and sized by `capacity`. Scans go
+    // through these rather than chasing `split` and `txn` for each entry.
+    // `dates` and `is_budget` are set when an entry is created, the rest when
+    // it's cooked. `amounts` are converted to the account's currency and
+    // balances are prefix sums of these.
+    time_t *dates;
+    bool *is_budget;
+    int64_t *amounts;
+    int64_t *balances;
+    int64_t *balances_with_budget;
+    // Incremental balance mode. We enter it when an amount changes after a
+    // cook. Our balance columns are then stale and balances come from
+    // Fenwick trees over `amounts` (without and with budget amounts), which
+    // let us update them in O(log n). We leave it when the whole list is
+    // cleared. The trees are only allocated while we're in that mode.
+    bool incremental;
+    int64_t *balancetree;
+    int64_t *budgettree;
 } EntryList;
 
 void
@@ -43,6 +96,10 @@ entry_amount_set(Entry *entry, const Amount *amount);
 void
 entry_copy(Entry *dst, const Entry *src);
 
+// Returns the split that we wrap.
+Split*
+entry_split(const Entry *entry);
+
 void
 entries_init(EntryList *entries, Account *account);
 
@@ -52,9 +109,52 @@ entries_deinit(EntryList *entries);
 bool
 entries_balance(const EntryList *entries, Amount *dst, time_t date, bool with_budget);
 
+/* Writes in `dst` the running balance of the cooked entry at `index`. */
+void
+entries_balance_at(
+    const EntryList *entries,
+    Amount *dst,
+    int index,
+    bool with_budget);
+
 bool
 entries_balance_of_reconciled(const EntryList *entries, Amount *dst);
 
+/* Writes in `dst` the current reconciled balance of `entry`, a cooked entry
+ * of `entries`.
+ */
+void
+entries_reconciled_balance(
+    const EntryList *entries,
+    const Entry *entry,
+    Amount *dst);
+
+/* Updates reconciled balances after a change in the reconciliation date of
+ * `entry`'s split, without re-cooking.
+ *
+ * This is only possible if `entry` keeps its place in reconciliation order,
+ * which is the case when toggling between no reconciliation date and a
+ * reconciliation date equal to the txn date. If it doesn't, or if `entry`
+ * isn't cooked, returns false and the list has to be re-cooked.
+ */
+bool
+entries_reconciliation_changed(EntryList *entries, Entry *entry);
+
+/* Updates balances after a change in the split amounts of `txn`, without
+ * re-cooking, by switching to incremental balance mode.
+ *
+ * `txn` must have the same date and the same splits as when it was cooked.
+ * Returns false if it has no cooked entry in `entries`, if one of its amounts
+ * can't be converted or if one of its entries changes place in
+ * reconciliation order. In those cases, we haven't changed anything and the
+ * list has to be re-cooked.
+ *
+ * Only amount changes are handled that way. Inserting or deleting entries
+ * still requires clearing and cooking from their date.
+ */
+bool
+entries_transaction_changed(EntryList *entries, const Transaction *txn);
+
 bool
 entries_cash_flow(
     const EntryList *entries,
@@ -62,6 +162,22 @@ entries_cash_flow(
     time_t from,
     time_t to);
 
+/* Writes in `dst` the last cooked entry of each date of the [from, to] range.
+ *
+ * The balances of these entries (see entries_balance_at()) are the ones of the
+ * account at the end of their date and form a step function of that balance over the range: the balance doesn't
+ * change between two steps. `dst` has to be large enough to hold all entries
+ * of the range (entries->count is always enough).
+ *
+ * Returns the number of entries written in `dst`.
+ */
+int
+entries_balance_steps(
+    const EntryList *entries,
+    Entry **dst,
+    time_t from,
+    time_t to);
+
 void
 entries_clear(EntryList *entries, time_t fromdate);
 
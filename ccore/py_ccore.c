@@ -1,5 +1,6 @@
 #include <Python.h>
 #include <datetime.h>
+#include <limits.h>
 #include <math.h>
 #include <stdbool.h>
 #include "amount.h"
@@ -9,6 +10,7 @@
 #include "accounts.h"
 #include "undo.h"
 #include "recurrence.h"
+#include "completion.h"
 #include "util.h"
 
 // NOTE ABOUT DECREF AND ERRORS
@@ -19,6 +21,20 @@
 // write the "return NULL" to avoid segfaults and thus allow better debugging.
 // but we don't care about memory leaks in this context.
 
+// NOTE ABOUT THE GIL
+//
+// Our heavy entry points (cooking, sorting, MRU lists, account filtering)
+// release the GIL during their pure C part. They first gather what they need
+// from their Python arguments and build their Python results only after having
+// re-acquired the GIL. While the GIL is released, no Python object is touched.
+//
+// The C structures they work on (AccountList, TransactionList and the
+// accounts, txns and entries they hold) have no locking of their own: they
+// must only be used from one thread at a time, which in moneyGuru is the main
+// thread. Other threads, like the rate fetching one, are free to run
+// meanwhile because the only thing they share with us is currency rates,
+// which are protected by a lock in currency.c.
+
 /* Types */
 static PyObject *UnsupportedCurrencyError = NULL;
 
@@ -59,9 +75,14 @@ static PyObject *AccountList_Type;
 #define AccountList_Check(v) (Py_TYPE(v) == (PyTypeObject *)AccountList_Type)
 
 // Assignment of money to an Account within a Transaction.
+//
+// We refer to our split through its txn and index rather than its address
+// because a txn's splits can be copied elsewhere when they're shared. See
+// "SHARED SPLITS" in transaction.h.
 typedef struct {
     PyObject_HEAD
-    Split *split;
+    Transaction *txn;
+    unsigned int index;
 } PySplit;
 
 static PyObject *Split_Type;
@@ -111,10 +132,11 @@ static PyObject *EntryList_Type;
 typedef struct {
     PyObject_HEAD
     TransactionList tlist;
-    // cache
+    // cache, valid as long as our MRUIndex version hasn't changed.
     PyObject *descriptions;
+    unsigned int descriptions_version;
     PyObject *payees;
-    PyObject *account_names;
+    unsigned int payees_version;
 } PyTransactionList;
 
 static PyObject *TransactionList_Type;
@@ -126,6 +148,13 @@ typedef struct {
 
 static PyObject *UndoStep_Type;
 
+typedef struct {
+    PyObject_HEAD
+    CompletionIndex index;
+} PyCompletionIndex;
+
+static PyObject *CompletionIndex_Type;
+
 /* Utils */
 static PyObject*
 time2pydate(time_t date)
@@ -133,14 +162,13 @@ time2pydate(time_t date)
     if (date == 0) {
         Py_RETURN_NONE;
     }
-    struct tm *d = gmtime(&date);
-    if (d == NULL) {
-        return PyErr_Format(
-            PyExc_ValueError,
-            "Couldn't convert time_t %ld\n",
-            date);
+    time_t days = date / SECS_IN_DAY;
+    if (date % SECS_IN_DAY < 0) {
+        days--;
     }
-    return PyDate_FromDate(d->tm_year + 1900, d->tm_mon + 1, d->tm_mday);
+    int year, month, day;
+    civil_from_days((int)days, &year, &month, &day);
+    return PyDate_FromDate(year, month, day);
 }
 
 // 0 mean no date. -1 means error.
@@ -149,8 +177,6 @@ pydate2time(PyObject *pydate)
 {
     // Special case: all return values are proper time values **except** 1
     // which means an error (0 means no date).
-    struct tm date = {0};
-
     if (pydate == Py_None) {
         return 0;
     }
@@ -158,11 +184,11 @@ pydate2time(PyObject *pydate)
         PyErr_SetString(PyExc_ValueError, "pydate2tm needs a date value");
         return -1;
     }
-    date.tm_year = PyDateTime_GET_YEAR(pydate) - 1900;
-    date.tm_mon = PyDateTime_GET_MONTH(pydate) - 1;
-    date.tm_mday = PyDateTime_GET_DAY(pydate);
-    time_t r = mktime(&date);
-    return r;
+    int days = days_from_civil(
+        PyDateTime_GET_YEAR(pydate),
+        PyDateTime_GET_MONTH(pydate),
+        PyDateTime_GET_DAY(pydate));
+    return (time_t)days * SECS_IN_DAY;
 }
 
 static bool
@@ -423,6 +449,69 @@ py_currency_set_CAD_value(PyObject *self, PyObject *args)
     return Py_None;
 }
 
+static PyObject*
+py_currency_set_CAD_values(PyObject *self, PyObject *args)
+{
+    char *code;
+    PyObject *rates_p;
+    Currency *c;
+
+    if (!PyArg_ParseTuple(args, "sO", &code, &rates_p)) {
+        return NULL;
+    }
+
+    c = getcur(code);
+    if (c == NULL) {
+        return NULL;
+    }
+    PyObject *fast = PySequence_Fast(rates_p, "rates must be a sequence");
+    if (fast == NULL) {
+        return NULL;
+    }
+    Py_ssize_t len = PySequence_Fast_GET_SIZE(fast);
+    if (len > INT_MAX) {
+        Py_DECREF(fast);
+        PyErr_SetString(PyExc_OverflowError, "too many rates");
+        return NULL;
+    }
+    time_t *dates = malloc(sizeof(time_t) * len);
+    double *values = malloc(sizeof(double) * len);
+    if (len && (dates == NULL || values == NULL)) {
+        free(dates);
+        free(values);
+        Py_DECREF(fast);
+        return PyErr_NoMemory();
+    }
+    for (Py_ssize_t i=0; i<len; i++) {
+        PyObject *pydate;
+        double rate;
+        PyObject *item = PySequence_Fast_GET_ITEM(fast, i); // borrowed
+        if (!PyArg_ParseTuple(item, "Od", &pydate, &rate)) {
+            free(dates);
+            free(values);
+            Py_DECREF(fast);
+            return NULL;
+        }
+        dates[i] = pydate2time(pydate);
+        if (dates[i] == -1) {
+            free(dates);
+            free(values);
+            Py_DECREF(fast);
+            return NULL;
+        }
+        values[i] = rate;
+    }
+    Py_DECREF(fast);
+    CurrencyResult res = currency_set_CAD_values(c, dates, values, (int)len);
+    free(dates);
+    free(values);
+    if (res != CURRENCY_OK) {
+        PyErr_SetString(PyExc_RuntimeError, "couldn't save rates");
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
 static PyObject*
 py_currency_daterange(PyObject *self, PyObject *args)
 {
@@ -859,6 +948,135 @@ py_amount_convert(PyObject *self, PyObject *args)
     return pyamount(&dest);
 }
 
+static PyObject*
+py_amount_convert_many(PyObject *self, PyObject *args)
+{
+    PyObject *amounts_p;
+    char *code;
+    PyObject *dates_p;
+
+    if (!PyArg_ParseTuple(args, "OsO", &amounts_p, &code, &dates_p)) {
+        return NULL;
+    }
+
+    Currency *currency = getcur(code);
+    if (currency == NULL) {
+        return NULL;
+    }
+    PyObject *res = NULL;
+    PyObject *dates_fast = NULL;
+    Amount *src = NULL;
+    Amount *dest = NULL;
+    time_t *dates = NULL;
+    PyObject *amounts_fast = PySequence_Fast(amounts_p, "amounts must be a sequence");
+    if (amounts_fast == NULL) {
+        return NULL;
+    }
+    dates_fast = PySequence_Fast(dates_p, "dates must be a sequence");
+    if (dates_fast == NULL) {
+        goto end;
+    }
+    Py_ssize_t len = PySequence_Fast_GET_SIZE(amounts_fast);
+    if (PySequence_Fast_GET_SIZE(dates_fast) != len) {
+        PyErr_SetString(PyExc_ValueError, "amounts and dates must have the same length");
+        goto end;
+    }
+    src = malloc(sizeof(Amount) * len);
+    dest = malloc(sizeof(Amount) * len);
+    dates = malloc(sizeof(time_t) * len);
+    if (len && (src == NULL || dest == NULL || dates == NULL)) {
+        PyErr_NoMemory();
+        goto end;
+    }
+    for (Py_ssize_t i=0; i<len; i++) {
+        PyObject *amount_p = PySequence_Fast_GET_ITEM(amounts_fast, i); // borrowed
+        if (!check_amount(amount_p)) {
+            PyErr_SetString(PyExc_TypeError, "not an amount");
+            goto end;
+        }
+        amount_copy(&src[i], get_amount(amount_p));
+        dates[i] = pydate2time(PySequence_Fast_GET_ITEM(dates_fast, i));
+        if (dates[i] == -1) {
+            goto end;
+        }
+    }
+    if (!amount_convert_many(dest, src, dates, len, currency)) {
+        PyErr_SetString(PyExc_ValueError, "problems getting a rate");
+        goto end;
+    }
+    res = PyList_New(len);
+    if (res == NULL) {
+        goto end;
+    }
+    for (Py_ssize_t i=0; i<len; i++) {
+        PyObject *item;
+        if (!src[i].val || src[i].currency == currency) {
+            // Like amount_convert(), we return the same instance.
+            item = PySequence_Fast_GET_ITEM(amounts_fast, i);
+            Py_INCREF(item);
+        } else {
+            item = pyamount(&dest[i]);
+        }
+        PyList_SET_ITEM(res, i, item); // stolen
+    }
+end:
+    Py_DECREF(amounts_fast);
+    Py_XDECREF(dates_fast);
+    free(src);
+    free(dest);
+    free(dates);
+    return res;
+}
+
+static Account**
+_pyseq2accounts(PyObject *seq)
+{
+    Account **res;
+    Py_ssize_t len = PySequence_Length(seq);
+    res = malloc(sizeof(Account*) * (len + 1));
+    PyObject *fast = PySequence_Fast(seq, "");
+    for (int i=0; i<len; i++) {
+        res[i] = ((PyAccount *)PySequence_Fast_GET_ITEM(fast, i))->account;
+    }
+    res[len] = NULL;
+    Py_DECREF(fast);
+    return res;
+}
+
+static Transaction**
+_pyseq2txns(PyObject *seq)
+{
+    Transaction **res;
+    Py_ssize_t len = PySequence_Length(seq);
+    res = malloc(sizeof(Transaction*) * (len + 1));
+    PyObject *fast = PySequence_Fast(seq, "");
+    for (int i=0; i<len; i++) {
+        res[i] = ((PyTransaction *)PySequence_Fast_GET_ITEM(fast, i))->txn;
+    }
+    res[len] = NULL;
+    Py_DECREF(fast);
+    return res;
+}
+
+// Returns completion_find() results as a Python list.
+static PyObject *
+_PyCompletionIndex_find(CompletionIndex *index, PyObject *prefix)
+{
+    const char *s = PyUnicode_AsUTF8(prefix);
+    if (s == NULL) {
+        return NULL;
+    }
+    const char **found = completion_find(index, s);
+    PyObject *res = PyList_New(0);
+    for (const char **iter = found; *iter != NULL; iter++) {
+        PyObject *value = _strget(*iter);
+        PyList_Append(res, value);
+        Py_DECREF(value);
+    }
+    free(found);
+    return res;
+}
+
 /* Account */
 static PyAccount*
 _PyAccount_from_account(Account *account)
@@ -1079,7 +1297,10 @@ PyAccount_change(PyAccount *self, PyObject *args, PyObject *kwds)
         self->account->type = type;
     }
     if (reference != NULL) {
-        if (!_strset(&self->account->reference, reference)) {
+        accounts_unindex(self->account->list, self->account);
+        bool ok = _strset(&self->account->reference, reference);
+        accounts_reindex(self->account->list, self->account);
+        if (!ok) {
             return NULL;
         }
     }
@@ -1089,7 +1310,10 @@ PyAccount_change(PyAccount *self, PyObject *args, PyObject *kwds)
         }
     }
     if (account_number != NULL) {
-        if (!_strset(&self->account->account_number, account_number)) {
+        accounts_unindex(self->account->list, self->account);
+        bool ok = _strset(&self->account->account_number, account_number);
+        accounts_reindex(self->account->list, self->account);
+        if (!ok) {
             return NULL;
         }
     }
@@ -1105,10 +1329,24 @@ PyAccount_change(PyAccount *self, PyObject *args, PyObject *kwds)
 }
 
 /* Split attrs */
+static Split*
+_PySplit_split(PySplit *self)
+{
+    return &self->txn->splits[self->index];
+}
+
+// Use this instead of _PySplit_split() when modifying the split.
+static Split*
+_PySplit_writable(PySplit *self)
+{
+    transaction_own_splits(self->txn);
+    return _PySplit_split(self);
+}
+
 static PyObject *
 PySplit_reconciliation_date(PySplit *self)
 {
-    return time2pydate(self->split->reconciliation_date);
+    return time2pydate(_PySplit_split(self)->reconciliation_date);
 }
 
 static int
@@ -1118,7 +1356,7 @@ PySplit_reconciliation_date_set(PySplit *self, PyObject *value)
     if (res == -1) {
         return -1;
     } else {
-        self->split->reconciliation_date = res;
+        _PySplit_writable(self)->reconciliation_date = res;
         return 0;
     }
 }
@@ -1126,34 +1364,34 @@ PySplit_reconciliation_date_set(PySplit *self, PyObject *value)
 static PyObject *
 PySplit_memo(PySplit *self)
 {
-    return _strget(self->split->memo);
+    return _strget(_PySplit_split(self)->memo);
 }
 
 static int
 PySplit_memo_set(PySplit *self, PyObject *value)
 {
-    return _strset(&self->split->memo, value) ? 0 : -1;
+    return _strset(&_PySplit_writable(self)->memo, value) ? 0 : -1;
 }
 
 static PyObject *
 PySplit_reference(PySplit *self)
 {
-    return _strget(self->split->reference);
+    return _strget(_PySplit_split(self)->reference);
 }
 
 static int
 PySplit_reference_set(PySplit *self, PyObject *value)
 {
-    return _strset(&self->split->reference, value) ? 0 : -1;
+    return _strset(&_PySplit_writable(self)->reference, value) ? 0 : -1;
 }
 
 static PyObject *
 PySplit_account(PySplit *self)
 {
-    if (self->split->account == NULL) {
+    if (_PySplit_split(self)->account == NULL) {
         Py_RETURN_NONE;
     } else {
-        return (PyObject *)_PyAccount_from_account(self->split->account);
+        return (PyObject *)_PyAccount_from_account(_PySplit_split(self)->account);
     }
 }
 
@@ -1169,14 +1407,14 @@ PySplit_account_set(PySplit *self, PyObject *value)
         PyAccount *account = (PyAccount *)value;
         newval = account->account;
     }
-    split_account_set(self->split, newval);
+    split_account_set(_PySplit_writable(self), newval);
     return 0;
 }
 
 static PyObject *
 PySplit_amount(PySplit *self)
 {
-    Split *split = self->split;
+    Split *split = _PySplit_split(self);
     return pyamount(&split->amount);
 }
 
@@ -1184,24 +1422,24 @@ static int
 PySplit_amount_set(PySplit *self, PyObject *value)
 {
     const Amount *amount = get_amount(value);
-    split_amount_set(self->split, amount);
+    split_amount_set(_PySplit_writable(self), amount);
     return 0;
 }
 
 static PyObject *
 PySplit_account_name(PySplit *self)
 {
-    if (self->split->account == NULL) {
+    if (_PySplit_split(self)->account == NULL) {
         return PyUnicode_InternFromString("");
     } else {
-        return _strget(self->split->account->name);
+        return _strget(_PySplit_split(self)->account->name);
     }
 }
 
 static PyObject *
 PySplit_credit(PySplit *self)
 {
-    Amount *a = &self->split->amount;
+    Amount *a = &_PySplit_split(self)->amount;
     if (a->val < 0) {
         return create_amount(-a->val, a->currency);
     } else {
@@ -1212,7 +1450,7 @@ PySplit_credit(PySplit *self)
 static PyObject *
 PySplit_debit(PySplit *self)
 {
-    Amount *a = &self->split->amount;
+    Amount *a = &_PySplit_split(self)->amount;
     if (a->val > 0) {
         return pyamount(a);
     } else {
@@ -1223,7 +1461,7 @@ PySplit_debit(PySplit *self)
 static PyObject *
 PySplit_reconciled(PySplit *self)
 {
-    if (self->split->reconciliation_date == 0) {
+    if (_PySplit_split(self)->reconciliation_date == 0) {
         Py_RETURN_FALSE;
     } else {
         Py_RETURN_TRUE;
@@ -1233,15 +1471,16 @@ PySplit_reconciled(PySplit *self)
 static PyObject *
 PySplit_index(PySplit *self)
 {
-    return PyLong_FromLong(self->split->index);
+    return PyLong_FromLong(self->index);
 }
 
 /* Split Methods */
 static PySplit*
-_PySplit_proxy(Split *split)
+_PySplit_proxy(Transaction *txn, unsigned int index)
 {
     PySplit *r = (PySplit *)PyType_GenericAlloc((PyTypeObject *)Split_Type, 0);
-    r->split = split;
+    r->txn = txn;
+    r->index = index;
     return r;
 }
 
@@ -1255,8 +1494,8 @@ PySplit_repr(PySplit *self)
         return NULL;
     }
     args = Py_BuildValue(
-        "(Ois)", aname, self->split->amount.val,
-        self->split->amount.currency->code);
+        "(Ois)", aname, _PySplit_split(self)->amount.val,
+        _PySplit_split(self)->amount.currency->code);
     fmt = PyUnicode_FromString("Split(%r Amount(%r, %r))");
     r = PyUnicode_Format(fmt, args);
     Py_DECREF(fmt);
@@ -1267,7 +1506,7 @@ PySplit_repr(PySplit *self)
 static Py_hash_t
 PySplit_hash(PySplit *self)
 {
-    return (Py_hash_t)self->split;
+    return (Py_hash_t)self->txn + self->index;
 }
 
 static PyObject *
@@ -1277,7 +1516,8 @@ PySplit_richcompare(PySplit *a, PyObject *b, int op)
         Py_RETURN_NOTIMPLEMENTED;
     }
     if ((op == Py_EQ) || (op == Py_NE)) {
-        bool match = a->split == ((PySplit *)b)->split;
+        PySplit *other = (PySplit *)b;
+        bool match = a->txn == other->txn && a->index == other->index;
         if (op == Py_NE) {
             match = !match;
         }
@@ -1316,6 +1556,9 @@ PyTransaction_date_set(PyTransaction *self, PyObject *value)
         return -1;
     } else {
         self->txn->date = res;
+        if (!self->owned) {
+            transactions_order_changed();
+        }
         return 0;
     }
 }
@@ -1378,6 +1621,9 @@ static int
 PyTransaction_position_set(PyTransaction *self, PyObject *value)
 {
     self->txn->position = PyLong_AsLong(value);
+    if (!self->owned) {
+        transactions_order_changed();
+    }
     return 0;
 }
 
@@ -1448,7 +1694,7 @@ PyTransaction_splits(PyTransaction *self)
 {
     PyObject *res = PyList_New(self->txn->splitcount);
     for (unsigned int i=0; i<self->txn->splitcount; i++) {
-        PySplit *split = _PySplit_proxy(&self->txn->splits[i]);
+        PySplit *split = _PySplit_proxy(self->txn, i);
         PyList_SetItem(res, i, (PyObject *)split); // stolen
     }
     return res;
@@ -1568,15 +1814,15 @@ static PyObject *
 PyTransaction_new_split(PyTransaction *self)
 {
     transaction_resize_splits(self->txn, self->txn->splitcount+1);
-    Split *newsplit = &self->txn->splits[self->txn->splitcount-1];
-    newsplit->index = self->txn->splitcount-1;
-    return (PyObject *)_PySplit_proxy(newsplit);
+    unsigned int index = self->txn->splitcount-1;
+    self->txn->splits[index].index = index;
+    return (PyObject *)_PySplit_proxy(self->txn, index);
 }
 
 static PyObject *
 PyTransaction_assign_imbalance(PyTransaction *self, PySplit *target_split)
 {
-    transaction_assign_imbalance(self->txn, target_split->split);
+    transaction_assign_imbalance(self->txn, _PySplit_split(target_split));
     Py_RETURN_NONE;
 }
 
@@ -1596,7 +1842,7 @@ PyTransaction_balance(PyTransaction *self, PyObject *args)
         PyErr_SetString(PyExc_TypeError, "not a split");
         return NULL;
     } else {
-        strong_split = ((PySplit *)strong_split_p)->split;
+        strong_split = _PySplit_split((PySplit *)strong_split_p);
     }
     transaction_balance(self->txn, strong_split, keep_two_splits);
     Py_RETURN_NONE;
@@ -1613,6 +1859,9 @@ PyTransaction_copy_from(PyTransaction *self, PyTransaction *other)
         PyErr_SetString(PyExc_RuntimeError, "low level copy failed");
         return NULL;
     }
+    if (!self->owned) {
+        transactions_order_changed();
+    }
     Py_RETURN_NONE;
 }
 
@@ -1672,6 +1921,11 @@ PyTransaction_change(PyTransaction *self, PyObject *args, PyObject *kwds)
             return NULL;
         }
     }
+    if (date_p != NULL || from_p != NULL || to_p != NULL || amount != NULL
+            || currency != NULL || splits != NULL) {
+        // Those can all end up modifying our splits.
+        transaction_own_splits(txn);
+    }
     if (date_p != NULL) {
         time_t date = pydate2time(date_p);
         if (date == -1) {
@@ -1788,7 +2042,7 @@ PyTransaction_change(PyTransaction *self, PyObject *args, PyObject *kwds)
         transaction_resize_splits(self->txn, len);
         for (int i=0; i<len; i++) {
             PySplit *split = (PySplit *)PyList_GetItem(splits, i); // borrowed
-            split_copy(&self->txn->splits[i], split->split);
+            split_copy(&self->txn->splits[i], _PySplit_split(split));
             self->txn->splits[i].index = i;
         }
     }
@@ -1800,6 +2054,10 @@ PyTransaction_change(PyTransaction *self, PyObject *args, PyObject *kwds)
         }
     }
     txn->mtime = now();
+    if (!self->owned) {
+        // our date changed
+        transactions_order_changed();
+    }
     Py_RETURN_NONE;
 }
 
@@ -1828,7 +2086,7 @@ PyTransaction_move_split(PyTransaction *self, PyObject *args)
     if (!PyArg_ParseTuple(args, "Oi", &split, &index)) {
         return NULL;
     }
-    if (!transaction_move_split(self->txn, split->split, index)) {
+    if (!transaction_move_split(self->txn, _PySplit_split(split), index)) {
         return NULL;
     }
     Py_RETURN_NONE;
@@ -1854,13 +2112,24 @@ PyTransaction_reassign_account(PyTransaction *self, PyObject *args)
 static PyObject *
 PyTransaction_remove_split(PyTransaction *self, PySplit *split)
 {
-    if (!transaction_remove_split(self->txn, split->split)) {
+    if (!transaction_remove_split(self->txn, _PySplit_split(split))) {
         return NULL;
     }
     transaction_balance(self->txn, NULL, false);
     Py_RETURN_NONE;
 }
 
+static PyObject *
+PyTransaction_share_splits(PyTransaction *self, PyTransaction *other)
+{
+    if (!PyObject_IsInstance((PyObject *)other, Transaction_Type)) {
+        PyErr_SetString(PyExc_TypeError, "not a txn");
+        return NULL;
+    }
+    transaction_share_splits(self->txn, other->txn);
+    Py_RETURN_NONE;
+}
+
 static PyObject *
 PyTransaction_repr(PyTransaction *self)
 {
@@ -1998,14 +2267,14 @@ PyEntry_init(PyEntry *self, PyObject *args, PyObject *kwds)
         PyErr_SetString(PyExc_TypeError, "not a txn");
         return -1;
     }
-    entry_init(&self->entry, split_p->split, transaction_p->txn);
+    entry_init(&self->entry, _PySplit_split(split_p), transaction_p->txn);
     return 0;
 }
 
 static PyObject *
 PyEntry_account(PyEntry *self)
 {
-    Split *split = self->entry.split;
+    Split *split = entry_split(&self->entry);
     if (split->account == NULL) {
         Py_RETURN_NONE;
     } else {
@@ -2016,7 +2285,7 @@ PyEntry_account(PyEntry *self)
 static PyObject *
 PyEntry_amount(PyEntry *self)
 {
-    return pyamount(&self->entry.split->amount);
+    return pyamount(&entry_split(&self->entry)->amount);
 }
 
 static PyObject *
@@ -2064,7 +2333,7 @@ PyEntry_mtime(PyEntry *self)
 static PyObject *
 PyEntry_reconciled(PyEntry *self)
 {
-    if (self->entry.split->reconciliation_date == 0) {
+    if (entry_split(&self->entry)->reconciliation_date == 0) {
         Py_RETURN_FALSE;
     } else {
         Py_RETURN_TRUE;
@@ -2080,19 +2349,19 @@ PyEntry_reconciled_balance(PyEntry *self)
 static PyObject *
 PyEntry_reconciliation_date(PyEntry *self)
 {
-    return time2pydate(self->entry.split->reconciliation_date);
+    return time2pydate(entry_split(&self->entry)->reconciliation_date);
 }
 
 static PyObject *
 PyEntry_reference(PyEntry *self)
 {
-    return _strget(self->entry.split->reference);
+    return _strget(entry_split(&self->entry)->reference);
 }
 
 static PyObject *
 PyEntry_split(PyEntry *self)
 {
-    return (PyObject *)_PySplit_proxy(self->entry.split);
+    return (PyObject *)_PySplit_proxy(self->entry.txn, self->entry.splitindex);
 }
 
 static PyObject *
@@ -2101,10 +2370,10 @@ PyEntry_splits(PyEntry *self)
     PyObject *res = PyList_New(self->entry.txn->splitcount - 1);
     int j = 0;
     for (unsigned int i=0; i<self->entry.txn->splitcount; i++) {
-        if (i == self->entry.split->index) {
+        if (i == self->entry.splitindex) {
             continue;
         }
-        PySplit *split = _PySplit_proxy(&self->entry.txn->splits[i]);
+        PySplit *split = _PySplit_proxy(self->entry.txn, i);
         PyList_SetItem(res, j, (PyObject *)split); // stolen
         j++;
     }
@@ -2121,9 +2390,10 @@ static PyObject *
 PyEntry_transfer(PyEntry *self)
 {
     PyObject *res = PyList_New(0);
+    Split *split = entry_split(&self->entry);
     for (unsigned int i=0; i<self->entry.txn->splitcount; i++) {
         Split *s = &self->entry.txn->splits[i];
-        if (s == self->entry.split) {
+        if (s == split) {
             continue;
         }
         if (s->account != NULL) {
@@ -2150,7 +2420,7 @@ PyEntry_normal_balance(PyEntry *self, PyObject *args)
 {
     Amount amount;
     amount_copy(&amount, &self->entry.balance);
-    Account *a = self->entry.split->account;
+    Account *a = entry_split(&self->entry)->account;
     if (a != NULL) {
         if (account_is_credit(a)) {
             amount.val *= -1;
@@ -2166,7 +2436,8 @@ PyEntry_richcompare(PyEntry *a, PyObject *b, int op)
         Py_RETURN_NOTIMPLEMENTED;
     }
     if (op == Py_EQ) {
-        if (a->entry.split == ((PyEntry *)b)->entry.split) {
+        Entry *other = &((PyEntry *)b)->entry;
+        if (a->entry.txn == other->txn && a->entry.splitindex == other->splitindex) {
             Py_RETURN_TRUE;
         } else {
             Py_RETURN_FALSE;
@@ -2186,7 +2457,7 @@ PyEntry_richcompare(PyEntry *a, PyObject *b, int op)
 static Py_hash_t
 PyEntry_hash(PyEntry *self)
 {
-    return (Py_hash_t)self->entry.split;
+    return (Py_hash_t)self->entry.txn + self->entry.splitindex;
 }
 
 static PyObject *
@@ -2209,10 +2480,18 @@ PyEntry_dealloc(PyEntry *self)
 }
 
 static PyEntry*
-_PyEntry_from_entry(Entry *entry)
+_PyEntry_from_entry(EntryList *entries, Entry *entry)
 {
     PyEntry *pyentry = (PyEntry *)PyType_GenericAlloc((PyTypeObject *)Entry_Type, 0);
     entry_copy(&pyentry->entry, entry);
+    // Balances stored in `entry` don't follow reconciliation_changed() and
+    // transaction_changed() calls. Uncooked entries have no balance to query
+    // and keep their zero balances.
+    if (entry->index >= 0 && entry->index < entries->cooked_until) {
+        entries_reconciled_balance(entries, entry, &pyentry->entry.reconciled_balance);
+        entries_balance_at(entries, &pyentry->entry.balance, entry->index, false);
+        entries_balance_at(entries, &pyentry->entry.balance_with_budget, entry->index, true);
+    }
     return pyentry;
 }
 
@@ -2239,7 +2518,7 @@ PyEntryList_last_entry(PyEntryList *self, PyObject *args)
     }
     Entry *entry = entries_last_entry(self->entries, date);
     if (entry != NULL) {
-        return (PyObject *)_PyEntry_from_entry(entry);
+        return (PyObject *)_PyEntry_from_entry(self->entries, entry);
     } else {
         Py_RETURN_NONE;
     }
@@ -2319,6 +2598,59 @@ PyEntryList_cash_flow(PyEntryList *self, PyObject *args)
     return pyamount(&res);
 }
 
+static PyObject*
+PyEntryList_balance_steps(PyEntryList *self, PyObject *args)
+{
+    PyObject *daterange;
+
+    if (!PyArg_ParseTuple(args, "O", &daterange)) {
+        return NULL;
+    }
+    PyObject *start = PyObject_GetAttrString(daterange, "start");
+    if (start == NULL) {
+        return NULL;
+    }
+    time_t from = pydate2time(start);
+    Py_DECREF(start);
+    if (from == -1) {
+        return NULL;
+    }
+    PyObject *end = PyObject_GetAttrString(daterange, "end");
+    if (end == NULL) {
+        return NULL;
+    }
+    time_t to = pydate2time(end);
+    Py_DECREF(end);
+    if (to == -1) {
+        return NULL;
+    }
+    Entry **steps = malloc(sizeof(Entry *) * (self->entries->count + 1));
+    if (steps == NULL) {
+        return PyErr_NoMemory();
+    }
+    int count = entries_balance_steps(self->entries, steps, from, to);
+    PyObject *res = PyList_New(count);
+    if (res == NULL) {
+        free(steps);
+        return NULL;
+    }
+    for (int i=0; i<count; i++) {
+        Entry *entry = steps[i];
+        Amount balance;
+        Amount balance_with_budget;
+        entries_balance_at(self->entries, &balance, entry->index, false);
+        entries_balance_at(self->entries, &balance_with_budget, entry->index, true);
+        PyObject *item = Py_BuildValue(
+            "(NNN)",
+            time2pydate(entry->txn->date),
+            pyamount(&balance),
+            pyamount(&balance_with_budget));
+        PyList_SET_ITEM(res, i, item); // stolen
+    }
+    free(steps);
+    return res;
+}
+
 static PyObject*
 PyEntryList_normal_balance(PyEntryList *self, PyObject *args)
 {
@@ -2375,13 +2707,51 @@ PyEntryList_normal_cash_flow(PyEntryList *self, PyObject *args)
     }
 }
 
+static PyObject*
+PyEntryList_reconciliation_changed(PyEntryList *self, PyObject *entry_p)
+{
+    if (!Entry_Check(entry_p)) {
+        PyErr_SetString(PyExc_TypeError, "not an entry");
+        return NULL;
+    }
+    // Our argument is a copy, let's find the real one.
+    Entry *copy = &((PyEntry *)entry_p)->entry;
+    int pos = copy->recpos;
+    if (pos < 0 || pos >= self->entries->cooked_until) {
+        Py_RETURN_FALSE;
+    }
+    Entry *entry = self->entries->byrec[pos];
+    if (entry->txn != copy->txn || entry->splitindex != copy->splitindex) {
+        Py_RETURN_FALSE;
+    }
+    if (entries_reconciliation_changed(self->entries, entry)) {
+        Py_RETURN_TRUE;
+    } else {
+        Py_RETURN_FALSE;
+    }
+}
+
+static PyObject*
+PyEntryList_transaction_changed(PyEntryList *self, PyObject *txn_p)
+{
+    if (!PyObject_IsInstance(txn_p, Transaction_Type)) {
+        PyErr_SetString(PyExc_TypeError, "not a transaction");
+        return NULL;
+    }
+    if (entries_transaction_changed(self->entries, ((PyTransaction *)txn_p)->txn)) {
+        Py_RETURN_TRUE;
+    } else {
+        Py_RETURN_FALSE;
+    }
+}
+
 static PyObject*
 PyEntryList_iter(PyEntryList *self)
 {
     PyObject *list = PyList_New(self->entries->count);
     for (int i=0; i<self->entries->count; i++) {
         Entry *entry = self->entries->entries[i];
-        PyList_SetItem(list, i, (PyObject *)_PyEntry_from_entry(entry));
+        PyList_SetItem(list, i, (PyObject *)_PyEntry_from_entry(self->entries, entry));
     }
     PyObject *res = PyObject_GetIter(list);
     Py_DECREF(list);
@@ -2516,8 +2886,10 @@ PyAccountList_create_from(PyAccountList *self, PyAccount *account)
         // We found an Account with the same name, but this Account's strings
         // must be deallocated before we copy over them.
         // This is not done if both PyAccounts point to the same Account.
+        accounts_unindex(&self->alist, a);
         account_deinit(a);
         account_copy(a, account->account);
+        accounts_reindex(&self->alist, a);
     }
     PyAccount *res = _PyAccount_from_account(a);
     return (PyObject *)res;
@@ -2532,6 +2904,10 @@ PyAccountList_entries_for_account(PyAccountList *self, PyAccount *account)
     }
     EntryList *entries = accounts_entries_for_account(
         &self->alist, account->account);
+    if (entries == NULL) {
+        PyErr_SetString(PyExc_ValueError, "account not in list");
+        return NULL;
+    }
     return (PyObject *)_PyEntryList_proxy(entries);
 }
 
@@ -2559,7 +2935,9 @@ PyAccountList_filter(PyAccountList *self, PyObject *args, PyObject *kwds)
         return NULL;
     }
 
-    PyObject *res = PyList_New(0);
+    Account **found = malloc(sizeof(Account*) * self->alist.count);
+    int count = 0;
+    Py_BEGIN_ALLOW_THREADS
     for (int i=0; i<self->alist.count; i++) {
         Account *a = self->alist.accounts[i];
         if (groupname != NULL) {
@@ -2577,8 +2955,16 @@ PyAccountList_filter(PyAccountList *self, PyObject *args, PyObject *kwds)
         if (type >= 0 && (int)a->type != type) {
             continue;
         }
-        PyList_Append(res, (PyObject *)_PyAccount_from_account(a));
+        found[count] = a;
+        count++;
     }
+    Py_END_ALLOW_THREADS
+    PyObject *res = PyList_New(count);
+    for (int i=0; i<count; i++) {
+        // steals the reference
+        PyList_SET_ITEM(res, i, (PyObject *)_PyAccount_from_account(found[i]));
+    }
+    free(found);
     return res;
 }
 
@@ -2771,38 +3157,67 @@ PyAccountList_dealloc(PyAccountList *self)
  *
  * This takes a list of transactions to cook. Adds entries directly in the
  * proper accounts.
+ *
+ * If the optional `threads` argument is > 1, running balances are computed by
+ * that many threads.
  */
 static PyObject*
 py_oven_cook_txns(PyObject *self, PyObject *args)
 {
     PyAccountList *accounts;
     PyObject *txns;
+    int threads = 0;
+    PyObject *dirty_p = Py_None;
 
-    if (!PyArg_ParseTuple(args, "OO", &accounts, &txns)) {
+    if (!PyArg_ParseTuple(args, "OO|iO", &accounts, &txns, &threads, &dirty_p)) {
         return NULL;
     }
-    Py_ssize_t len = PySequence_Length(txns);
-    for (int i=0; i<len; i++) {
-        PyTransaction *txn = (PyTransaction *)PyList_GetItem(txns, i); // borrowed
-        int slen = txn->txn->splitcount;
-        for (int j=0; j<slen; j++) {
-            Split *split = &txn->txn->splits[j];
+    // When we have dirty accounts, we only create entries for them. Indexed
+    // by account id.
+    bool *dirty = NULL;
+    if (dirty_p != Py_None) {
+        PyObject *iter = PyObject_GetIter(dirty_p);
+        if (iter == NULL) {
+            return NULL;
+        }
+        dirty = calloc(accounts->alist.next_id + 1, sizeof(bool));
+        PyObject *item;
+        while ((item = PyIter_Next(iter))) {
+            if (Account_Check(item)) {
+                EntryList *entries = accounts_entries_for_account(
+                    &accounts->alist, ((PyAccount *)item)->account);
+                if (entries != NULL) {
+                    dirty[entries->account->id] = true;
+                }
+            }
+            Py_DECREF(item);
+        }
+        Py_DECREF(iter);
+    }
+    Transaction **tocook = _pyseq2txns(txns);
+    Py_BEGIN_ALLOW_THREADS
+    for (Transaction **iter = tocook; *iter != NULL; iter++) {
+        Transaction *txn = *iter;
+        for (unsigned int j=0; j<txn->splitcount; j++) {
+            Split *split = &txn->splits[j];
             if (split->account == NULL) {
                 continue;
             }
             EntryList *entries = accounts_entries_for_account(
                 &accounts->alist, split->account);
-            entries_create(entries, split, txn->txn);
+            if (entries == NULL) {
+                continue;
+            }
+            if (dirty != NULL && !dirty[entries->account->id]) {
+                continue;
+            }
+            entries_create(entries, split, txn);
         }
     }
-
-    GHashTableIter iter;
-    g_hash_table_iter_init(&iter, accounts->alist.a2entries);
-
-    gpointer _, entries;
-    while (g_hash_table_iter_next(&iter, &_, &entries)) {
-        entries_cook(entries);
-    }
+    accounts_cook(&accounts->alist, threads);
+    Py_END_ALLOW_THREADS
+    free(dirty);
+    free(tocook);
     Py_RETURN_NONE;
 }
 
@@ -2822,6 +3237,28 @@ py_patch_today(PyObject *self, PyObject *today_p)
     Py_RETURN_NONE;
 }
 
+// Returns -1 and sets an exception if `type` isn't a valid repeat type.
+static int
+_str2repeattype(const char *type)
+{
+    if (strcmp(type, "daily") == 0) {
+        return REPEAT_DAILY;
+    } else if (strcmp(type, "weekly") == 0) {
+        return REPEAT_WEEKLY;
+    } else if (strcmp(type, "monthly") == 0) {
+        return REPEAT_MONTHLY;
+    } else if (strcmp(type, "yearly") == 0) {
+        return REPEAT_YEARLY;
+    } else if (strcmp(type, "weekday") == 0) {
+        return REPEAT_WEEKDAY;
+    } else if (strcmp(type, "weekday_last") == 0) {
+        return REPEAT_WEEKDAY_LAST;
+    } else {
+        PyErr_SetString(PyExc_ValueError, "invalid type");
+        return -1;
+    }
+}
+
 static PyObject*
 py_inc_date(PyObject *self, PyObject *args)
 {
@@ -2836,21 +3273,8 @@ py_inc_date(PyObject *self, PyObject *args)
     if (date == -1) {
         return NULL;
     }
-    RepeatType rt;
-    if (strcmp(type, "daily") == 0) {
-        rt = REPEAT_DAILY;
-    } else if (strcmp(type, "weekly") == 0) {
-        rt = REPEAT_WEEKLY;
-    } else if (strcmp(type, "monthly") == 0) {
-        rt = REPEAT_MONTHLY;
-    } else if (strcmp(type, "yearly") == 0) {
-        rt = REPEAT_YEARLY;
-    } else if (strcmp(type, "weekday") == 0) {
-        rt = REPEAT_WEEKDAY;
-    } else if (strcmp(type, "weekday_last") == 0) {
-        rt = REPEAT_WEEKDAY_LAST;
-    } else {
-        PyErr_SetString(PyExc_ValueError, "invalid type");
+    int rt = _str2repeattype(type);
+    if (rt < 0) {
         return NULL;
     }
     time_t res = inc_date(date, rt, count);
@@ -2861,6 +3285,69 @@ py_inc_date(PyObject *self, PyObject *args)
     }
 }
 
+static PyObject*
+py_recurrence_dates(PyObject *self, PyObject *args)
+{
+    PyObject *base_py, *end_py;
+    char *type;
+    int every;
+    int index = 0;
+
+    if (!PyArg_ParseTuple(
+            args, "OsiO|i", &base_py, &type, &every, &end_py, &index)) {
+        return NULL;
+    }
+    time_t base = pydate2time(base_py);
+    if (base == -1) {
+        return NULL;
+    }
+    time_t end = pydate2time(end_py);
+    if (end == -1) {
+        return NULL;
+    }
+    int rt = _str2repeattype(type);
+    if (rt < 0) {
+        return NULL;
+    }
+    int count = 0;
+    int capacity = 64;
+    time_t *dates = malloc(sizeof(time_t) * capacity);
+    if (dates == NULL) {
+        return PyErr_NoMemory();
+    }
+    while (true) {
+        int written = recurrence_dates(
+            base, rt, every, end, &index, &dates[count], capacity - count);
+        count += written;
+        if (count < capacity) {
+            break;
+        }
+        capacity *= 2;
+        time_t *newdates = realloc(dates, sizeof(time_t) * capacity);
+        if (newdates == NULL) {
+            free(dates);
+            return PyErr_NoMemory();
+        }
+        dates = newdates;
+    }
+    PyObject *res = PyList_New(count);
+    if (res == NULL) {
+        free(dates);
+        return NULL;
+    }
+    for (int i=0; i<count; i++) {
+        PyObject *date = time2pydate(dates[i]);
+        if (date == NULL) {
+            Py_DECREF(res);
+            free(dates);
+            return NULL;
+        }
+        PyList_SET_ITEM(res, i, date);
+    }
+    free(dates);
+    return Py_BuildValue("(Ni)", res, index);
+}
+
 /* PyTransactionList */
 
 static int
@@ -2876,37 +3363,14 @@ PyTransactionList_init(PyTransactionList *self, PyObject *args, PyObject *kwds)
     transactions_init(&self->tlist);
     self->descriptions = NULL;
     self->payees = NULL;
-    self->account_names = NULL;
     return 0;
 }
 
+// Converts a NULL-terminated list of strings to a Python list and frees it.
 static PyObject*
-PyTransactionList_clear_cache(PyTransactionList *self)
+_PyTransactionList_strlist(char **strings)
 {
-    if (self->descriptions != NULL) {
-        Py_DECREF(self->descriptions);
-        self->descriptions = NULL;
-    }
-    if (self->payees != NULL) {
-        Py_DECREF(self->payees);
-        self->payees = NULL;
-    }
-    if (self->account_names != NULL) {
-        Py_DECREF(self->account_names);
-        self->account_names = NULL;
-    }
-    Py_RETURN_NONE;
-}
-
-static PyObject*
-PyTransactionList_account_names(PyTransactionList *self)
-{
-    if (self->account_names != NULL) {
-        Py_INCREF(self->account_names);
-        return self->account_names;
-    }
-    char **account_names = transactions_account_names(&self->tlist);
-    char **iter = account_names;
+    char **iter = strings;
     PyObject *res = PyList_New(0);
     while (*iter != NULL) {
         PyObject *s = _strget(*iter);
@@ -2914,12 +3378,19 @@ PyTransactionList_account_names(PyTransactionList *self)
         Py_DECREF(s);
         iter++;
     }
-    free(account_names);
-    self->account_names = res;
-    Py_INCREF(self->account_names);
+    free(strings);
     return res;
 }
 
+static PyObject*
+PyTransactionList_account_names(PyTransactionList *self)
+{
+    // Not cached: account names and their "inactive" flag change behind our
+    // back. Our MRU index makes this cheap anyway.
+    return _PyTransactionList_strlist(
+        transactions_account_names(&self->tlist));
+}
+
 static PyObject*
 PyTransactionList_add(PyTransactionList *self, PyObject *args)
 {
@@ -2968,14 +3439,34 @@ PyTransactionList_add(PyTransactionList *self, PyObject *args)
         txn->txn->ref = toadd;
     }
     transactions_add(&self->tlist, toadd, keep_position);
-    PyTransactionList_clear_cache(self);
     Py_RETURN_NONE;
 }
 
+static PyObject*
+PyTransactionList_changed(PyTransactionList *self, PyTransaction *txn)
+{
+    transactions_changed(&self->tlist, txn->txn);
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+PyTransactionList_complete_description(PyTransactionList *self, PyObject *prefix)
+{
+    return _PyCompletionIndex_find(
+        &self->tlist.descriptions.completion, prefix);
+}
+
+static PyObject*
+PyTransactionList_complete_payee(PyTransactionList *self, PyObject *prefix)
+{
+    return _PyCompletionIndex_find(&self->tlist.payees.completion, prefix);
+}
+
 static PyObject*
 PyTransactionList_clear(PyTransactionList *self, PyObject *args)
 {
-    PyTransactionList_clear_cache(self);
+    Py_CLEAR(self->descriptions);
+    Py_CLEAR(self->payees);
     transactions_deinit(&self->tlist);
     transactions_init(&self->tlist);
     Py_RETURN_NONE;
@@ -2984,28 +3475,21 @@ PyTransactionList_clear(PyTransactionList *self, PyObject *args)
 static PyObject*
 PyTransactionList_descriptions(PyTransactionList *self)
 {
-    if (self->descriptions != NULL) {
-        Py_INCREF(self->descriptions);
-        return self->descriptions;
-    }
-    char **descs = transactions_descriptions(&self->tlist);
-    char **iter = descs;
-    PyObject *res = PyList_New(0);
-    while (*iter != NULL) {
-        PyObject *s = _strget(*iter);
-        PyList_Append(res, s);
-        Py_DECREF(s);
-        iter++;
+    if (self->descriptions == NULL ||
+            self->descriptions_version != self->tlist.descriptions.version) {
+        Py_XDECREF(self->descriptions);
+        self->descriptions = _PyTransactionList_strlist(
+            transactions_descriptions(&self->tlist));
+        self->descriptions_version = self->tlist.descriptions.version;
     }
-    free(descs);
-    self->descriptions = res;
     Py_INCREF(self->descriptions);
-    return res;
+    return self->descriptions;
 }
 
 static PyObject*
 PyTransactionList_first(PyTransactionList *self, PyObject *args)
 {
+    transactions_sort(&self->tlist);
     if (!self->tlist.count) {
         PyErr_SetString(PyExc_IndexError, "");
         return NULL;
@@ -3016,6 +3500,7 @@ PyTransactionList_first(PyTransactionList *self, PyObject *args)
 static PyObject*
 PyTransactionList_last(PyTransactionList *self, PyObject *args)
 {
+    transactions_sort(&self->tlist);
     if (!self->tlist.count) {
         PyErr_SetString(PyExc_IndexError, "");
         return NULL;
@@ -3027,23 +3512,15 @@ PyTransactionList_last(PyTransactionList *self, PyObject *args)
 static PyObject*
 PyTransactionList_payees(PyTransactionList *self)
 {
-    if (self->payees != NULL) {
-        Py_INCREF(self->payees);
-        return self->payees;
-    }
-    char **payees = transactions_payees(&self->tlist);
-    char **iter = payees;
-    PyObject *res = PyList_New(0);
-    while (*iter != NULL) {
-        PyObject *s = _strget(*iter);
-        PyList_Append(res, s);
-        Py_DECREF(s);
-        iter++;
+    if (self->payees == NULL ||
+            self->payees_version != self->tlist.payees.version) {
+        Py_XDECREF(self->payees);
+        self->payees = _PyTransactionList_strlist(
+            transactions_payees(&self->tlist));
+        self->payees_version = self->tlist.payees.version;
     }
-    free(payees);
-    self->payees = res;
     Py_INCREF(self->payees);
-    return res;
+    return self->payees;
 }
 
 static PyObject *
@@ -3081,7 +3558,6 @@ PyTransactionList_reassign_account(PyTransactionList *self, PyObject *args)
         reassign_to = reassign_to_p->account;
     }
     transactions_reassign_account(&self->tlist, account, reassign_to);
-    PyTransactionList_clear_cache(self);
     Py_RETURN_NONE;
 }
 
@@ -3091,14 +3567,24 @@ PyTransactionList_remove(PyTransactionList *self, PyTransaction *txn)
     if (!transactions_remove(&self->tlist, txn->txn)) {
         return NULL;
     }
-    PyTransactionList_clear_cache(self);
+    Py_RETURN_NONE;
+}
+
+static PyObject*
+PyTransactionList_remove_many(PyTransactionList *self, PyObject *txns)
+{
+    Transaction **toremove = _pyseq2txns(txns);
+    transactions_remove_many(&self->tlist, toremove);
+    free(toremove);
     Py_RETURN_NONE;
 }
 
 static PyObject*
 PyTransactionList_sort(PyTransactionList *self, PyObject *args)
 {
+    Py_BEGIN_ALLOW_THREADS
     transactions_sort(&self->tlist);
+    Py_END_ALLOW_THREADS
     Py_RETURN_NONE;
 }
 
@@ -3145,6 +3631,7 @@ PyTransactionList_contains(PyTransactionList *self, PyTransaction *txn)
 static PyObject*
 PyTransactionList_iter(PyTransactionList *self)
 {
+    transactions_sort(&self->tlist);
     PyObject *list = PyList_New(self->tlist.count);
     for (unsigned int i=0; i<self->tlist.count; i++) {
         PyList_SetItem(
@@ -3167,42 +3654,11 @@ PyTransactionList_dealloc(PyTransactionList *self)
     transactions_deinit(&self->tlist);
     Py_XDECREF(self->descriptions);
     Py_XDECREF(self->payees);
-    Py_XDECREF(self->account_names);
     Py_TYPE(self)->tp_free(self);
 }
 
 /* PyUndoStep */
 
-static Account**
-_pyseq2accounts(PyObject *seq)
-{
-    Account **res;
-    Py_ssize_t len = PySequence_Length(seq);
-    res = malloc(sizeof(Account*) * (len + 1));
-    PyObject *fast = PySequence_Fast(seq, "");
-    for (int i=0; i<len; i++) {
-        res[i] = ((PyAccount *)PySequence_Fast_GET_ITEM(fast, i))->account;
-    }
-    res[len] = NULL;
-    Py_DECREF(fast);
-    return res;
-}
-
-static Transaction**
-_pyseq2txns(PyObject *seq)
-{
-    Transaction **res;
-    Py_ssize_t len = PySequence_Length(seq);
-    res = malloc(sizeof(Transaction*) * (len + 1));
-    PyObject *fast = PySequence_Fast(seq, "");
-    for (int i=0; i<len; i++) {
-        res[i] = ((PyTransaction *)PySequence_Fast_GET_ITEM(fast, i))->txn;
-    }
-    res[len] = NULL;
-    Py_DECREF(fast);
-    return res;
-}
-
 static int
 PyUndoStep_init(PyUndoStep *self, PyObject *args, PyObject *kwds)
 {
@@ -3264,6 +3720,19 @@ PyUndoStep_redo(PyUndoStep *self, PyObject *args)
     Py_RETURN_NONE;
 }
 
+static PyObject *
+PyUndoStep_compact(PyUndoStep *self, PyObject *args)
+{
+    undostep_compact(&self->step);
+    Py_RETURN_NONE;
+}
+
+static PyObject *
+PyUndoStep_footprint(PyUndoStep *self)
+{
+    return PyLong_FromSize_t(undostep_footprint(&self->step));
+}
+
 static void
 PyUndoStep_dealloc(PyUndoStep *self)
 {
@@ -3271,6 +3740,62 @@ PyUndoStep_dealloc(PyUndoStep *self)
     Py_TYPE(self)->tp_free(self);
 }
 
+/* PyCompletionIndex */
+
+static int
+PyCompletionIndex_init(PyCompletionIndex *self, PyObject *args, PyObject *kwds)
+{
+    PyObject *candidates;
+
+    // We can be initialized more than once. Our memory is zeroed on
+    // allocation, so `values` tells us whether we already were.
+    if (self->index.values != NULL) {
+        completion_deinit(&self->index);
+    }
+    // dealloc() deinits our index, even on errors.
+    completion_init(&self->index);
+    if (!PyArg_ParseTuple(args, "O", &candidates)) {
+        return -1;
+    }
+    PyObject *iter = PyObject_GetIter(candidates);
+    if (iter == NULL) {
+        return -1;
+    }
+    PyObject *item;
+    while ((item = PyIter_Next(iter))) {
+        const char *s = PyUnicode_AsUTF8(item);
+        Py_DECREF(item);
+        if (s == NULL) {
+            Py_DECREF(iter);
+            return -1;
+        }
+        completion_add(&self->index, s);
+    }
+    Py_DECREF(iter);
+    return 0;
+}
+
+static PyObject *
+PyCompletionIndex_complete(PyCompletionIndex *self, PyObject *prefix)
+{
+    return _PyCompletionIndex_find(&self->index, prefix);
+}
+
+static Py_ssize_t
+PyCompletionIndex_len(PyCompletionIndex *self)
+{
+    return self->index.count;
+}
+
+static void
+PyCompletionIndex_dealloc(PyCompletionIndex *self)
+{
+    if (self->index.values != NULL) {
+        completion_deinit(&self->index);
+    }
+    Py_TYPE(self)->tp_free(self);
+}
+
 /* Python Boilerplate */
 
 static PyGetSetDef PyAmount_getseters[] = {
@@ -3403,15 +3928,26 @@ static PyMethodDef module_methods[] = {
     {"amount_format", (PyCFunction)py_amount_format, METH_VARARGS | METH_KEYWORDS},
     {"amount_parse", (PyCFunction)py_amount_parse, METH_VARARGS | METH_KEYWORDS},
     {"amount_convert", (PyCFunction)py_amount_convert, METH_VARARGS},
+    // Converts a sequence of amounts, each at its corresponding date in a
+    // sequence of dates, into a currency. Returns a list of amounts.
+    {"amount_convert_many", (PyCFunction)py_amount_convert_many, METH_VARARGS},
     {"currency_global_init", py_currency_global_init, METH_VARARGS},
     {"currency_global_reset_currencies", py_currency_global_reset_currencies, METH_NOARGS},
     {"currency_register", py_currency_register, METH_VARARGS},
     {"currency_getrate", py_currency_getrate, METH_VARARGS},
     {"currency_set_CAD_value", py_currency_set_CAD_value, METH_VARARGS},
+    // Sets all (date, rate) pairs of a sequence for a currency, in one DB
+    // transaction.
+    {"currency_set_CAD_values", py_currency_set_CAD_values, METH_VARARGS},
     {"currency_daterange", py_currency_daterange, METH_VARARGS},
     {"oven_cook_txns", py_oven_cook_txns, METH_VARARGS},
     {"patch_today", py_patch_today, METH_O},
     {"inc_date", py_inc_date, METH_VARARGS},
+    // Returns the list of all dates of a recurrence up to an end date, in one
+    // go. Arguments are `base_date, repeat_type, repeat_every, end[, index]`.
+    // Returns `(dates, index)`: start again with that index to get the dates
+    // that follow. See DateCounter.
+    {"recurrence_dates", py_recurrence_dates, METH_VARARGS},
     {NULL}  /* Sentinel */
 };
 
@@ -3420,6 +3956,10 @@ static PyMethodDef PyEntryList_methods[] = {
     // If `currency` is specified, the result is converted to it.
     // if `with_budget` is True, budget spawns are counted.
     {"balance", (PyCFunction)PyEntryList_balance, METH_VARARGS, ""},
+    // Returns a list of `(date, balance, balance_with_budget)` for each date
+    // of `date_range` that has entries, balances being the ones at the end of
+    // that date. The balance doesn't change between two of these dates.
+    {"balance_steps", (PyCFunction)PyEntryList_balance_steps, METH_VARARGS, ""},
     // Returns the sum of entry amounts occuring in `date_range`.
     // If `currency` is specified, the result is converted to it.
     {"cash_flow", (PyCFunction)PyEntryList_cash_flow, METH_VARARGS, ""},
@@ -3430,6 +3970,13 @@ static PyMethodDef PyEntryList_methods[] = {
     {"last_entry", (PyCFunction)PyEntryList_last_entry, METH_VARARGS, ""},
     {"normal_balance", (PyCFunction)PyEntryList_normal_balance, METH_VARARGS, ""},
     {"normal_cash_flow", (PyCFunction)PyEntryList_normal_cash_flow, METH_VARARGS, ""},
+    // Updates reconciled balances after a change in `entry`'s reconciliation
+    // date. Returns False if that can't be done without re-cooking, which is
+    // the case when `entry` moves in reconciliation order.
+    {"reconciliation_changed", (PyCFunction)PyEntryList_reconciliation_changed, METH_O, ""},
+    // Updates balances after a change in split amounts of `txn`. Returns False
+    // if `txn` has no cooked entry in the list.
+    {"transaction_changed", (PyCFunction)PyEntryList_transaction_changed, METH_O, ""},
     {0, 0, 0, 0},
 };
 
@@ -3552,6 +4099,9 @@ static PyMethodDef PyTransaction_methods[] = {
     {"reassign_account", (PyCFunction)PyTransaction_reassign_account, METH_VARARGS, ""},
     {"remove_split", (PyCFunction)PyTransaction_remove_split, METH_O, ""},
     {"replicate", (PyCFunction)PyTransaction_replicate, METH_NOARGS, ""},
+    // Replaces our splits with those of the txn in argument, without copying
+    // them. They're copied when either txn modifies them.
+    {"share_splits", (PyCFunction)PyTransaction_share_splits, METH_O, ""},
     // Same as replicate(), but gets rid of the "spawn" attribute.
     {"materialize", (PyCFunction)PyTransaction_materialize, METH_NOARGS, ""},
     {0, 0, 0, 0},
@@ -3600,14 +4150,21 @@ PyType_Spec Transaction_Type_Spec = {
 
 static PyMethodDef PyTransactionList_methods[] = {
     {"add", (PyCFunction)PyTransactionList_add, METH_VARARGS, ""},
+    // Call it after changing the description, payee, accounts or mtime of one
+    // of our txns.
+    {"changed", (PyCFunction)PyTransactionList_changed, METH_O, ""},
     {"clear", (PyCFunction)PyTransactionList_clear, METH_NOARGS, ""},
-    {"clear_cache", (PyCFunction)PyTransactionList_clear_cache, METH_NOARGS, ""},
+    // Returns our descriptions that start with a prefix, most recent first.
+    {"complete_description", (PyCFunction)PyTransactionList_complete_description, METH_O, ""},
+    {"complete_payee", (PyCFunction)PyTransactionList_complete_payee, METH_O, ""},
     {"first", (PyCFunction)PyTransactionList_first, METH_NOARGS, ""},
     {"last", (PyCFunction)PyTransactionList_last, METH_NOARGS, ""},
     {"move_before", (PyCFunction)PyTransactionList_move_before, METH_VARARGS, ""},
     {"move_last", (PyCFunction)PyTransactionList_move_last, METH_O, ""},
     {"reassign_account", (PyCFunction)PyTransactionList_reassign_account, METH_VARARGS, ""},
     {"remove", (PyCFunction)PyTransactionList_remove, METH_O, ""},
+    // Removes all txns of a sequence. Txns that aren't in the list are ignored.
+    {"remove_many", (PyCFunction)PyTransactionList_remove_many, METH_O, ""},
     {"sort", (PyCFunction)PyTransactionList_sort, METH_NOARGS, ""},
     {"transactions_at_date", (PyCFunction)PyTransactionList_transactions_at_date, METH_O, ""},
     {0, 0, 0, 0},
@@ -3642,6 +4199,11 @@ PyType_Spec TransactionList_Type_Spec = {
 static PyMethodDef PyUndoStep_methods[] = {
     {"undo", (PyCFunction)PyUndoStep_undo, METH_VARARGS, ""},
     {"redo", (PyCFunction)PyUndoStep_redo, METH_VARARGS, ""},
+    // Only keeps the transaction fields that the recorded change touched.
+    // Call it once that change has been made.
+    {"compact", (PyCFunction)PyUndoStep_compact, METH_NOARGS, ""},
+    // Number of bytes held by the step.
+    {"footprint", (PyCFunction)PyUndoStep_footprint, METH_NOARGS, ""},
     {0, 0, 0, 0},
 };
 
@@ -3660,6 +4222,28 @@ PyType_Spec UndoStep_Type_Spec = {
     UndoStep_Slots,
 };
 
+static PyMethodDef PyCompletionIndex_methods[] = {
+    // Returns candidates starting with `prefix`, most likely first.
+    {"complete", (PyCFunction)PyCompletionIndex_complete, METH_O, ""},
+    {0, 0, 0, 0},
+};
+
+static PyType_Slot CompletionIndex_Slots[] = {
+    {Py_tp_init, PyCompletionIndex_init},
+    {Py_tp_methods, PyCompletionIndex_methods},
+    {Py_sq_length, PyCompletionIndex_len},
+    {Py_tp_dealloc, PyCompletionIndex_dealloc},
+    {0, 0},
+};
+
+PyType_Spec CompletionIndex_Type_Spec = {
+    "_ccore.CompletionIndex",
+    sizeof(PyCompletionIndex),
+    0,
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    CompletionIndex_Slots,
+};
+
 static struct PyModuleDef CCoreDef = {
     PyModuleDef_HEAD_INIT,
     "_ccore",
@@ -3719,5 +4303,8 @@ PyInit__ccore(void)
 
     UndoStep_Type = PyType_FromSpec(&UndoStep_Type_Spec);
     PyModule_AddObject(m, "UndoStep", UndoStep_Type);
+
+    CompletionIndex_Type = PyType_FromSpec(&CompletionIndex_Type_Spec);
+    PyModule_AddObject(m, "CompletionIndex", CompletionIndex_Type);
     return m;
 }
@@ -1,10 +1,66 @@
 #include "recurrence.h"
+#include "util.h"
 
 /* Private */
+
+/* Dates are days since epoch, plus a time of day that we leave untouched.
+ * All our computations are done on civil dates with integer arithmetic:
+ * going through localtime() and mktime() at each step is slow and isn't
+ * thread-safe.
+ */
+static int
+_date2day(time_t date)
+{
+    time_t day = date / SECS_IN_DAY;
+    if (date % SECS_IN_DAY < 0) {
+        day--;
+    }
+    return (int)day;
+}
+
+// Returns `date` moved to `day`, at the same time of day.
+static time_t
+_moveto(time_t date, int day)
+{
+    return date + (time_t)(day - _date2day(date)) * SECS_IN_DAY;
+}
+
+static int
+_days_in_month(int year, int month)
+{
+    static const int days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month == 2 && year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)) {
+        return 29;
+    }
+    return days[month - 1];
+}
+
+// 0 is sunday, like tm_wday
+static int
+_weekday(int day)
+{
+    // 1970-01-01 was a thursday
+    int res = (day + 4) % 7;
+    return res < 0 ? res + 7 : res;
+}
+
+// Moves `year` and `month` `count` months forward.
+static void
+_add_months(int *year, int *month, int count)
+{
+    int months = *year * 12 + (*month - 1) + count;
+    int y = months / 12;
+    if (months % 12 < 0) {
+        y--;
+    }
+    *year = y;
+    *month = months - y * 12 + 1;
+}
+
 static time_t
 _inc_daily(time_t date, int count)
 {
-    return date + (SECS_IN_DAY * count);
+    return date + ((time_t)SECS_IN_DAY * count);
 }
 
 static time_t
@@ -16,21 +72,16 @@ _inc_weekly(time_t date, int count)
 static time_t
 _inc_monthly(time_t date, int count)
 {
-    struct tm *d = localtime(&date);
-    if (d == NULL) {
-        return -1;
-    }
-    d->tm_mon += count;
-    int day_before = d->tm_mday;
-    time_t res = mktime(d);
-    if (day_before != d->tm_mday) {
-        // mktime() normalized our tm struct, which means that we had an
-        // out of bound day (31st or 29+ in Feb). What we want now is the last
-        // day of the previous month.
-        d->tm_mday = 0; // "1 - 1", normalized by glibc
-        res = mktime(d);
+    int year, month, day;
+    civil_from_days(_date2day(date), &year, &month, &day);
+    _add_months(&year, &month, count);
+    int maxday = _days_in_month(year, month);
+    if (day > maxday) {
+        // We had an out of bound day (31st or 29+ in Feb). What we want is
+        // the last day of the target month.
+        day = maxday;
     }
-    return res;
+    return _moveto(date, days_from_civil(year, month, day));
 }
 
 static time_t
@@ -42,53 +93,39 @@ _inc_yearly(time_t date, int count)
 static time_t
 _inc_weekday(time_t date, int count)
 {
-    struct tm *d = localtime(&date);
-    if (d == NULL) {
-        return -1;
-    }
-    int wday = d->tm_wday;
-    int wno = (d->tm_mday - 1) / 7;
-    // now that we have our target wday and wno, go in "first day of the month"
-    // mode so that we can calculate the difference from there.
-    d->tm_mday = 1;
-    d->tm_mon += count;
-    mktime(d);
-    int diff = wday - d->tm_wday;
+    int year, month, day;
+    int days = _date2day(date);
+    civil_from_days(days, &year, &month, &day);
+    int wday = _weekday(days);
+    int wno = (day - 1) / 7;
+    _add_months(&year, &month, count);
+    int diff = wday - _weekday(days_from_civil(year, month, 1));
     if (diff < 0) {
         diff += 7;
     }
-    d->tm_mday = wno * 7 + diff + 1;
-    int month_before = d->tm_mon;
-    time_t res = mktime(d);
-    if (d->tm_mon != month_before) {
-        // tm_day went out of bounds. The day we're trying to get doesn't
-        // exist for the given month. Error.
+    day = wno * 7 + diff + 1;
+    if (day > _days_in_month(year, month)) {
+        // The day we're trying to get doesn't exist for the given month.
+        // Error.
         return -1;
-    } else {
-        return res;
     }
-
+    return _moveto(date, days_from_civil(year, month, day));
 }
 
 static time_t
 _inc_weekday_last(time_t date, int count)
 {
-    struct tm *d = localtime(&date);
-    if (d == NULL) {
-        return -1;
-    }
-    int wday = d->tm_wday;
-    // day 0 is out of bounds, but because we do "count + 1" below, that will
-    // give us the last day of our target month.
-    d->tm_mday = 0;
-    d->tm_mon += count + 1;
-    mktime(d);
-    int diff = d->tm_wday - wday;
+    int year, month, day;
+    int days = _date2day(date);
+    civil_from_days(days, &year, &month, &day);
+    int wday = _weekday(days);
+    _add_months(&year, &month, count);
+    int last = days_from_civil(year, month, _days_in_month(year, month));
+    int diff = _weekday(last) - wday;
     if (diff < 0) {
         diff += 7;
     }
-    d->tm_mday -= diff;
-    return mktime(d);
+    return _moveto(date, last - diff);
 }
 
 /* Public */
@@ -105,3 +142,42 @@ inc_date(time_t date, RepeatType repeat_type, int count)
         default: return date;
     }
 }
+
+int
+recurrence_dates(
+    time_t base,
+    RepeatType repeat_type,
+    int every,
+    time_t end,
+    int *index,
+    time_t *dst,
+    int max)
+{
+    int count = 0;
+    while (count < max && base <= end) {
+        if (*index > 0 && every <= 0) {
+            // We'd never move forward
+            break;
+        }
+        time_t date = inc_date(base, repeat_type, *index * every);
+        if (date == -1) {
+            // A skipped beat. Move on unless the month it's in is already
+            // past `end`.
+            int year, month, day;
+            civil_from_days(_date2day(base), &year, &month, &day);
+            _add_months(&year, &month, *index * every);
+            if (_moveto(base, days_from_civil(year, month, 1)) > end) {
+                break;
+            }
+            (*index)++;
+            continue;
+        }
+        if (date > end) {
+            break;
+        }
+        dst[count] = date;
+        count++;
+        (*index)++;
+    }
+    return count;
+}
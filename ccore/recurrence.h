@@ -33,3 +33,25 @@ typedef enum {
  */
 time_t
 inc_date(time_t date, RepeatType repeat_type, int count);
+
+/* Writes in `dst` the dates at which a recurrence starting at `base` and
+ * repeating every `every` units of `repeat_type` happens, up to `end`.
+ *
+ * Those dates are `base` incremented by `*index * every`, `(*index + 1) *
+ * every` and so on, skipping increments for which inc_date() fails. Start
+ * with an `*index` of 0 to get `base` itself first. We write at most `max`
+ * dates and update `*index` to the first increment we haven't written, so
+ * that we can be called again to get the following dates.
+ *
+ * Returns the number of dates written in `dst`. When it's lower than `max`,
+ * there are no more dates up to `end`.
+ */
+int
+recurrence_dates(
+    time_t base,
+    RepeatType repeat_type,
+    int every,
+    time_t end,
+    int *index,
+    time_t *dst,
+    int max);
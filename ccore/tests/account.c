@@ -1,5 +1,6 @@
 #include <CUnit/CUnit.h>
 #include <locale.h>
+#include <stdio.h>
 #include "../accounts.h"
 #include "../currency.h"
 #include "../util.h"
@@ -65,6 +66,20 @@ static void test_accounts_find_account_number()
     strset(&a1->account_number, "1234");
     Account *found = accounts_find_by_name(&al, "1234");
     CU_ASSERT_PTR_EQUAL(found, a1);
+    // A name match wins over a number match, even from a later account.
+    Account *a2 = accounts_create(&al);
+    account_init(a2, "1234", NULL, ACCOUNT_ASSET);
+    found = accounts_find_by_name(&al, "1234");
+    CU_ASSERT_PTR_EQUAL(found, a2);
+    // Among number matches, the first account wins.
+    Account *a3 = accounts_create(&al);
+    account_init(a3, "bar", NULL, ACCOUNT_ASSET);
+    strset(&a3->account_number, "42");
+    Account *a4 = accounts_create(&al);
+    account_init(a4, "baz", NULL, ACCOUNT_ASSET);
+    strset(&a4->account_number, "42");
+    found = accounts_find_by_name(&al, "42");
+    CU_ASSERT_PTR_EQUAL(found, a3);
     accounts_deinit(&al);
 }
 
@@ -113,6 +128,153 @@ static void test_accounts_rename()
     accounts_deinit(&al);
 }
 
+static void test_accounts_index_in_sync()
+{
+    // Our name and number indexes follow removals, undeletions and number
+    // changes.
+    AccountList al;
+    accounts_init(&al, NULL);
+    Account *a1 = accounts_create(&al);
+    account_init(a1, "one", NULL, ACCOUNT_ASSET);
+    strset(&a1->account_number, "1234");
+    Account *a2 = accounts_create(&al);
+    account_init(a2, "two", NULL, ACCOUNT_ASSET);
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_name(&al, "1234"), a1);
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_name(&al, "two"), a2);
+
+    accounts_unindex(&al, a1);
+    strset(&a1->account_number, "4242");
+    accounts_reindex(&al, a1);
+    CU_ASSERT_PTR_NULL(accounts_find_by_name(&al, "1234"));
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_name(&al, "4242"), a1);
+
+    CU_ASSERT_TRUE(accounts_remove(&al, a1));
+    CU_ASSERT_PTR_NULL(accounts_find_by_name(&al, "one"));
+    CU_ASSERT_PTR_NULL(accounts_find_by_name(&al, "4242"));
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_name(&al, "two"), a2);
+    CU_ASSERT_TRUE(accounts_undelete(&al, a1));
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_name(&al, "one"), a1);
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_name(&al, "4242"), a1);
+
+    // Changes in another list leave our indexes alone.
+    AccountList other;
+    accounts_init(&other, NULL);
+    Account *o1 = accounts_create(&other);
+    account_init(o1, "other", NULL, ACCOUNT_ASSET);
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_name(&other, "other"), o1);
+    accounts_unindex(o1->list, o1);
+    strset(&o1->account_number, "1234");
+    accounts_reindex(o1->list, o1);
+    CU_ASSERT_EQUAL(al.indexed, 2);
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_name(&other, "1234"), o1);
+    accounts_deinit(&other);
+
+    // When a shared number goes away, the next account with it takes over.
+    accounts_unindex(&al, a2);
+    strset(&a2->account_number, "4242");
+    accounts_reindex(&al, a2);
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_name(&al, "4242"), a2);
+    accounts_unindex(&al, a2);
+    strset(&a2->account_number, "");
+    accounts_reindex(&al, a2);
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_name(&al, "4242"), a1);
+    accounts_deinit(&al);
+}
+
+
+static void test_accounts_find_by_reference()
+{
+    AccountList al;
+    accounts_init(&al, NULL);
+    Account *a1 = accounts_create(&al);
+    account_init(a1, "one", NULL, ACCOUNT_ASSET);
+    strset(&a1->reference, "ref1");
+    Account *a2 = accounts_create(&al);
+    account_init(a2, "two", NULL, ACCOUNT_ASSET);
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_reference(&al, "ref1"), a1);
+    CU_ASSERT_PTR_NULL(accounts_find_by_reference(&al, ""));
+    CU_ASSERT_PTR_NULL(accounts_find_by_reference(&al, "ref2"));
+    accounts_unindex(&al, a2);
+    strset(&a2->reference, "ref2");
+    accounts_reindex(&al, a2);
+    CU_ASSERT_PTR_EQUAL(accounts_find_by_reference(&al, "ref2"), a2);
+    accounts_remove(&al, a1);
+    CU_ASSERT_PTR_NULL(accounts_find_by_reference(&al, "ref1"));
+    accounts_deinit(&al);
+}
+
+static void test_accounts_entries_for_account()
+{
+    // Entries follow their account through renames. Accounts from another
+    // list get the entries of our account with the same name.
+    AccountList al, other;
+    accounts_init(&al, NULL);
+    accounts_init(&other, NULL);
+    Account *a1 = accounts_create(&al);
+    account_init(a1, "one", NULL, ACCOUNT_ASSET);
+    Account *a2 = accounts_create(&al);
+    account_init(a2, "two", NULL, ACCOUNT_ASSET);
+    CU_ASSERT_EQUAL(a1->id, 0);
+    CU_ASSERT_EQUAL(a2->id, 1);
+    EntryList *el = accounts_entries_for_account(&al, a2);
+    CU_ASSERT_PTR_EQUAL(el->account, a2);
+    CU_ASSERT_TRUE(accounts_rename(&al, a2, "renamed"));
+    CU_ASSERT_PTR_EQUAL(accounts_entries_for_account(&al, a2), el);
+
+    Account *o1 = accounts_create(&other);
+    account_init(o1, "foo", NULL, ACCOUNT_ASSET);
+    Account *o2 = accounts_create(&other);
+    account_init(o2, "RENAMED", NULL, ACCOUNT_ASSET);
+    CU_ASSERT_PTR_NULL(accounts_entries_for_account(&al, o1));
+    CU_ASSERT_PTR_EQUAL(accounts_entries_for_account(&al, o2), el);
+    accounts_deinit(&al);
+    accounts_deinit(&other);
+}
+
+static void test_accounts_cook_threads()
+{
+    // Cooking with many threads gives the same running balances as cooking
+    // sequentially, foreign amounts included.
+    Currency *USD = currency_get("USD");
+    Currency *CAD = currency_get("CAD");
+    AccountList al;
+    accounts_init(&al, USD);
+    Account *accounts[10];
+    for (int i=0; i<10; i++) {
+        accounts[i] = accounts_create(&al);
+        char name[8];
+        snprintf(name, 8, "a%d", i);
+        account_init(accounts[i], name, USD, ACCOUNT_ASSET);
+    }
+    static Transaction txns[1000];
+    for (int i=0; i<1000; i++) {
+        Transaction *t = &txns[i];
+        transaction_init(t, TXN_TYPE_NORMAL, (i + 1) * 86400);
+        Split *s = transaction_add_split(t);
+        // uneven: account 0 gets half of the txns
+        s->account = accounts[i % 2 ? 0 : (i / 2) % 10];
+        amount_set(&s->amount, i, i % 3 ? USD : CAD);
+        entries_create(accounts_entries_for_account(&al, s->account), s, t);
+    }
+    CU_ASSERT_TRUE(accounts_cook(&al, 4));
+    Amount expected[10];
+    for (int i=0; i<10; i++) {
+        EntryList *el = accounts_entries_for_account(&al, accounts[i]);
+        CU_ASSERT_EQUAL(el->cooked_until, el->count);
+        amount_copy(&expected[i], &el->entries[el->count-1]->balance);
+        // force a re-cook
+        el->cooked_until = 0;
+    }
+    CU_ASSERT_TRUE(accounts_cook(&al, 1));
+    for (int i=0; i<10; i++) {
+        EntryList *el = accounts_entries_for_account(&al, accounts[i]);
+        CU_ASSERT_EQUAL(el->entries[el->count-1]->balance.val, expected[i].val);
+    }
+    accounts_deinit(&al);
+    for (int i=0; i<1000; i++) {
+        transaction_deinit(&txns[i]);
+    }
+}
 
 void test_account_init()
 {
@@ -124,5 +286,9 @@ void test_account_init()
     CU_ADD_TEST(s, test_accounts_find_account_number);
     CU_ADD_TEST(s, test_accounts_remove);
     CU_ADD_TEST(s, test_accounts_rename);
+    CU_ADD_TEST(s, test_accounts_index_in_sync);
+    CU_ADD_TEST(s, test_accounts_find_by_reference);
+    CU_ADD_TEST(s, test_accounts_entries_for_account);
+    CU_ADD_TEST(s, test_accounts_cook_threads);
 }
 
@@ -0,0 +1,75 @@
+#include <CUnit/CUnit.h>
+#include <stdlib.h>
+#include "../completion.h"
+
+static void test_find()
+{
+    // Candidates are stripped and deduplicated. Matches are case and
+    // diacritics insensitive and come in the order candidates were added.
+    CompletionIndex index;
+    completion_init(&index);
+    CU_ASSERT_TRUE(completion_add(&index, "bar"));
+    CU_ASSERT_TRUE(completion_add(&index, " Bazooka "));
+    CU_ASSERT_FALSE(completion_add(&index, "bar "));
+    CU_ASSERT_FALSE(completion_add(&index, "  "));
+    CU_ASSERT_FALSE(completion_add(&index, ""));
+    CU_ASSERT_TRUE(completion_add(&index, "électrique"));
+    CU_ASSERT_TRUE(completion_add(&index, "Ba"));
+    CU_ASSERT_EQUAL(index.count, 4);
+
+    const char **res = completion_find(&index, "BA");
+    CU_ASSERT_STRING_EQUAL(res[0], "bar");
+    CU_ASSERT_STRING_EQUAL(res[1], "Bazooka");
+    CU_ASSERT_STRING_EQUAL(res[2], "Ba");
+    CU_ASSERT_PTR_NULL(res[3]);
+    free(res);
+    res = completion_find(&index, "E");
+    CU_ASSERT_STRING_EQUAL(res[0], "électrique");
+    CU_ASSERT_PTR_NULL(res[1]);
+    free(res);
+    res = completion_find(&index, "z");
+    CU_ASSERT_PTR_NULL(res[0]);
+    free(res);
+    completion_deinit(&index);
+}
+
+static void test_update()
+{
+    // Candidates can be removed and re-ranked after lookups.
+    CompletionIndex index;
+    completion_init(&index);
+    CompletionRank rank = {0, 2};
+    CU_ASSERT_TRUE(completion_set(&index, "foo", rank));
+    rank.minor = 1;
+    CU_ASSERT_TRUE(completion_set(&index, " Foobar", rank));
+    const char **res = completion_find(&index, "fo");
+    CU_ASSERT_STRING_EQUAL(res[0], "Foobar");
+    CU_ASSERT_STRING_EQUAL(res[1], "foo");
+    CU_ASSERT_PTR_NULL(res[2]);
+    free(res);
+    rank.major = -1;
+    CU_ASSERT_FALSE(completion_set(&index, "foo", rank));
+    CU_ASSERT_TRUE(completion_add(&index, "fob"));
+    res = completion_find(&index, "fo");
+    CU_ASSERT_STRING_EQUAL(res[0], "foo");
+    CU_ASSERT_STRING_EQUAL(res[1], "fob");
+    CU_ASSERT_STRING_EQUAL(res[2], "Foobar");
+    CU_ASSERT_PTR_NULL(res[3]);
+    free(res);
+    CU_ASSERT_TRUE(completion_remove(&index, "Foobar "));
+    CU_ASSERT_FALSE(completion_remove(&index, "Foobar"));
+    CU_ASSERT_EQUAL(index.count, 2);
+    res = completion_find(&index, "foob");
+    CU_ASSERT_PTR_NULL(res[0]);
+    free(res);
+    completion_deinit(&index);
+}
+
+void test_completion_init()
+{
+    CU_pSuite s;
+
+    s = CU_add_suite("Completion", NULL, NULL);
+    CU_ADD_TEST(s, test_find);
+    CU_ADD_TEST(s, test_update);
+}
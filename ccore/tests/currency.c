@@ -0,0 +1,135 @@
+// for setenv()
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <CUnit/CUnit.h>
+#include "../currency.h"
+#include "../util.h"
+
+static time_t mkdate(int year, int month, int day)
+{
+    struct tm d = {0};
+    d.tm_year = year - 1900;
+    d.tm_mon = month - 1;
+    d.tm_mday = day;
+    return mktime(&d);
+}
+
+static double getrate(time_t date, Currency *c1, Currency *c2)
+{
+    double res = 0;
+    CU_ASSERT_EQUAL(currency_getrate(date, c1, c2, &res), CURRENCY_OK);
+    return res;
+}
+
+static void test_getrate_seek()
+{
+    currency_global_init(":memory:");
+    Currency *USD = currency_get("USD");
+    Currency *CAD = currency_get("CAD");
+    // Don't change the set order, we want to test that rates stay sorted.
+    currency_set_CAD_value(mkdate(2008, 4, 25), USD, 1.25);
+    currency_set_CAD_value(mkdate(2008, 4, 20), USD, 1.2);
+    CU_ASSERT_DOUBLE_EQUAL(getrate(mkdate(2008, 4, 20), USD, CAD), 1.2, 0.000001);
+    CU_ASSERT_DOUBLE_EQUAL(getrate(mkdate(2008, 4, 22), USD, CAD), 1.2, 0.000001);
+    CU_ASSERT_DOUBLE_EQUAL(getrate(mkdate(2008, 4, 26), USD, CAD), 1.25, 0.000001);
+    // No rate before? seek forward.
+    CU_ASSERT_DOUBLE_EQUAL(getrate(mkdate(2008, 4, 19), USD, CAD), 1.2, 0.000001);
+}
+
+static void test_set_after_get()
+{
+    // Rates set after our in-memory rates are loaded are taken into account.
+    currency_global_init(":memory:");
+    Currency *USD = currency_get("USD");
+    Currency *CAD = currency_get("CAD");
+    currency_set_CAD_value(mkdate(2008, 4, 20), USD, 1.2);
+    CU_ASSERT_DOUBLE_EQUAL(getrate(mkdate(2008, 4, 22), USD, CAD), 1.2, 0.000001);
+    currency_set_CAD_value(mkdate(2008, 4, 21), USD, 1.3);
+    currency_set_CAD_value(mkdate(2008, 4, 20), USD, 1.1);
+    CU_ASSERT_DOUBLE_EQUAL(getrate(mkdate(2008, 4, 22), USD, CAD), 1.3, 0.000001);
+    CU_ASSERT_DOUBLE_EQUAL(getrate(mkdate(2008, 4, 20), USD, CAD), 1.1, 0.000001);
+}
+
+static void test_new_db_flushes_rates()
+{
+    // When we open a new DB, we don't keep rates from the old one around.
+    currency_global_init(":memory:");
+    Currency *USD = currency_get("USD");
+    currency_set_CAD_value(mkdate(2008, 4, 20), USD, 1.2);
+    double rate;
+    CU_ASSERT_EQUAL(currency_getrate(mkdate(2008, 4, 20), USD, currency_get("CAD"), &rate), CURRENCY_OK);
+    currency_global_init(":memory:");
+    // USD's latest_rate fallback
+    CU_ASSERT_DOUBLE_EQUAL(getrate(mkdate(2008, 4, 20), USD, currency_get("CAD")), 1.0128, 0.000001);
+}
+
+static void test_register_many()
+{
+    // Lookups keep working when the registry grows past its initial block,
+    // and a reset forgets everything but our 3 base currencies.
+    char code[CURRENCY_CODE_MAXLEN+1];
+    for (int i=0; i<250; i++) {
+        snprintf(code, sizeof(code), "X%03d", i);
+        CU_ASSERT_PTR_NOT_NULL(currency_register(code, 2, 0, 1, 0, 1));
+    }
+    for (int i=0; i<250; i++) {
+        snprintf(code, sizeof(code), "X%03d", i);
+        Currency *cur = currency_get(code);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(cur);
+        CU_ASSERT_STRING_EQUAL(cur->code, code);
+    }
+    CU_ASSERT_PTR_NULL(currency_get("X250"));
+    CU_ASSERT_PTR_NULL(currency_get(""));
+    currency_global_reset_currencies();
+    CU_ASSERT_PTR_NULL(currency_get("X000"));
+    CU_ASSERT_STRING_EQUAL(currency_get("USD")->code, "USD");
+    CU_ASSERT_STRING_EQUAL(currency_get("EUR")->code, "EUR");
+    CU_ASSERT_STRING_EQUAL(currency_get("CAD")->code, "CAD");
+}
+
+static void test_daterange()
+{
+    // Dates read back from the DB are UTC days, like all our dates, whatever
+    // the local timezone.
+    currency_global_init(":memory:");
+    Currency *USD = currency_get("USD");
+    time_t start = (time_t)days_from_civil(2008, 4, 20) * 86400;
+    time_t stop = (time_t)days_from_civil(2008, 4, 25) * 86400;
+    currency_set_CAD_value(stop, USD, 1.25);
+    currency_set_CAD_value(start, USD, 1.2);
+    // getenv()'s result doesn't survive setenv()
+    char tz[64] = {0};
+    bool hadtz = getenv("TZ") != NULL;
+    if (hadtz) {
+        snprintf(tz, sizeof(tz), "%s", getenv("TZ"));
+    }
+    setenv("TZ", "EST5", 1);
+    tzset();
+    time_t found_start = 0;
+    time_t found_stop = 0;
+    CU_ASSERT_TRUE(currency_daterange(USD, &found_start, &found_stop));
+    if (hadtz) {
+        setenv("TZ", tz, 1);
+    } else {
+        unsetenv("TZ");
+    }
+    tzset();
+    CU_ASSERT_EQUAL(found_start, start);
+    CU_ASSERT_EQUAL(found_stop, stop);
+}
+
+void test_currency_init()
+{
+    CU_pSuite s;
+
+    s = CU_add_suite("Currency", NULL, NULL);
+    CU_ADD_TEST(s, test_getrate_seek);
+    CU_ADD_TEST(s, test_set_after_get);
+    CU_ADD_TEST(s, test_new_db_flushes_rates);
+    CU_ADD_TEST(s, test_register_many);
+    CU_ADD_TEST(s, test_daterange);
+}
+
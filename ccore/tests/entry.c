@@ -0,0 +1,311 @@
+#include <CUnit/CUnit.h>
+#include "../entry.h"
+#include "../account.h"
+#include "../currency.h"
+
+#define TXNCOUNT 1000
+
+static void test_create_many()
+{
+    // Entry pointers stay valid as the list grows, clearing keeps the first
+    // entries intact and re-created entries are cooked properly.
+    Currency *USD = currency_get("USD");
+    Account a = {0};
+    account_init(&a, "foo", USD, ACCOUNT_ASSET);
+    static Transaction txns[TXNCOUNT];
+    EntryList el;
+    entries_init(&el, &a);
+    Entry *first = NULL;
+    for (int i=0; i<TXNCOUNT; i++) {
+        Transaction *t = &txns[i];
+        transaction_init(t, TXN_TYPE_NORMAL, (i + 1) * 86400);
+        Split *s = transaction_add_split(t);
+        s->account = &a;
+        amount_set(&s->amount, 1, USD);
+        Entry *e = entries_create(&el, s, t);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(e);
+        if (first == NULL) {
+            first = e;
+        }
+    }
+    CU_ASSERT_EQUAL(el.count, TXNCOUNT);
+    CU_ASSERT_PTR_EQUAL(el.entries[0], first);
+    CU_ASSERT_PTR_EQUAL(entry_split(el.entries[0]), &txns[0].splits[0]);
+    CU_ASSERT(entries_cook(&el));
+    CU_ASSERT_EQUAL(el.entries[TXNCOUNT-1]->balance.val, TXNCOUNT);
+
+    entries_clear(&el, 501 * 86400);
+    CU_ASSERT_EQUAL(el.count, 500);
+    CU_ASSERT_EQUAL(el.entries[499]->balance.val, 500);
+    for (int i=500; i<TXNCOUNT; i++) {
+        Transaction *t = &txns[i];
+        entries_create(&el, &t->splits[0], t);
+    }
+    CU_ASSERT_EQUAL(el.count, TXNCOUNT);
+    CU_ASSERT_PTR_EQUAL(el.entries[0], first);
+    CU_ASSERT(entries_cook(&el));
+    CU_ASSERT_EQUAL(el.entries[TXNCOUNT-1]->balance.val, TXNCOUNT);
+
+    entries_deinit(&el);
+    for (int i=0; i<TXNCOUNT; i++) {
+        transaction_deinit(&txns[i]);
+    }
+    account_deinit(&a);
+}
+
+static void test_cash_flow()
+{
+    // Cash flow is the sum of non-budget amounts in the date range, whether
+    // we're in a single currency account or not.
+    Currency *USD = currency_get("USD");
+    Currency *CAD = currency_get("CAD");
+    Account a = {0};
+    account_init(&a, "foo", USD, ACCOUNT_INCOME);
+    Transaction txns[10];
+    EntryList el;
+    entries_init(&el, &a);
+    for (int i=0; i<10; i++) {
+        Transaction *t = &txns[i];
+        transaction_init(t, i == 4 ? TXN_TYPE_BUDGET : TXN_TYPE_NORMAL, (i + 1) * 86400);
+        Split *s = transaction_add_split(t);
+        s->account = &a;
+        amount_set(&s->amount, i + 1, USD);
+        entries_create(&el, s, t);
+    }
+    CU_ASSERT(entries_cook(&el));
+    CU_ASSERT_EQUAL(el.first_foreign, -1);
+    // Budget amounts only count in balances with budget.
+    CU_ASSERT_EQUAL(el.balances[9], 55 - 5);
+    CU_ASSERT_EQUAL(el.balances_with_budget[9], 55);
+    CU_ASSERT_EQUAL(el.entries[9]->balance.val, 55 - 5);
+    Amount res;
+    res.currency = USD;
+    CU_ASSERT(entries_cash_flow(&el, &res, 3 * 86400, 6 * 86400));
+    CU_ASSERT_EQUAL(res.val, 3 + 4 + 6);
+    CU_ASSERT(entries_cash_flow(&el, &res, 0, 86400));
+    CU_ASSERT_EQUAL(res.val, 1);
+    CU_ASSERT(entries_cash_flow(&el, &res, 11 * 86400, 12 * 86400));
+    CU_ASSERT_EQUAL(res.val, 0);
+    CU_ASSERT(entries_cash_flow(&el, &res, 6 * 86400, 3 * 86400));
+    CU_ASSERT_EQUAL(res.val, 0);
+
+    // Now, with a foreign amount at the end.
+    entries_clear(&el, 10 * 86400);
+    amount_set(&txns[9].splits[0].amount, 0, CAD);
+    entries_create(&el, &txns[9].splits[0], &txns[9]);
+    CU_ASSERT(entries_cook(&el));
+    CU_ASSERT_EQUAL(el.first_foreign, -1); // zero amounts don't count
+    entries_clear(&el, 10 * 86400);
+    amount_set(&txns[9].splits[0].amount, 10, CAD);
+    entries_create(&el, &txns[9].splits[0], &txns[9]);
+    CU_ASSERT(entries_cook(&el));
+    CU_ASSERT_EQUAL(el.first_foreign, 9);
+    CU_ASSERT(entries_cash_flow(&el, &res, 3 * 86400, 6 * 86400));
+    CU_ASSERT_EQUAL(res.val, 3 + 4 + 6);
+    // Clearing the foreign entry brings us back to a single currency account
+    entries_clear(&el, 10 * 86400);
+    CU_ASSERT_EQUAL(el.first_foreign, -1);
+
+    entries_deinit(&el);
+    for (int i=0; i<10; i++) {
+        transaction_deinit(&txns[i]);
+    }
+    account_deinit(&a);
+}
+
+static void test_reconciliation()
+{
+    // Toggling reconciliation updates reconciled balances the same way a
+    // re-cook would, and clearing keeps them right even when a kept entry
+    // comes after cleared ones in reconciliation order.
+    Currency *USD = currency_get("USD");
+    Account a = {0};
+    account_init(&a, "foo", USD, ACCOUNT_ASSET);
+    Transaction txns[10];
+    EntryList el;
+    entries_init(&el, &a);
+    for (int i=0; i<10; i++) {
+        Transaction *t = &txns[i];
+        transaction_init(t, TXN_TYPE_NORMAL, (i + 1) * 86400);
+        t->position = i;
+        Split *s = transaction_add_split(t);
+        s->account = &a;
+        amount_set(&s->amount, i + 1, USD);
+        entries_create(&el, s, t);
+    }
+    // Entry 1 is reconciled on day 9, after entries 2 to 7.
+    txns[1].splits[0].reconciliation_date = 9 * 86400;
+    txns[3].splits[0].reconciliation_date = txns[3].date;
+    CU_ASSERT(entries_cook(&el));
+    Amount res;
+    CU_ASSERT(entries_balance_of_reconciled(&el, &res));
+    CU_ASSERT_EQUAL(res.val, 2 + 4);
+    CU_ASSERT_PTR_EQUAL(el.last_reconciled, el.entries[1]);
+    entries_reconciled_balance(&el, el.entries[5], &res);
+    CU_ASSERT_EQUAL(res.val, 4);
+
+    txns[5].splits[0].reconciliation_date = txns[5].date;
+    CU_ASSERT(entries_reconciliation_changed(&el, el.entries[5]));
+    txns[3].splits[0].reconciliation_date = 0;
+    CU_ASSERT(entries_reconciliation_changed(&el, el.entries[3]));
+    entries_reconciled_balance(&el, el.entries[5], &res);
+    CU_ASSERT_EQUAL(res.val, 6);
+    entries_reconciled_balance(&el, el.entries[1], &res);
+    CU_ASSERT_EQUAL(res.val, 6 + 2);
+    txns[9].splits[0].reconciliation_date = txns[9].date;
+    CU_ASSERT(entries_reconciliation_changed(&el, el.entries[9]));
+    CU_ASSERT_PTR_EQUAL(el.last_reconciled, el.entries[9]);
+    // Moving in reconciliation order requires a re-cook.
+    txns[0].splits[0].reconciliation_date = 20 * 86400;
+    CU_ASSERT_FALSE(entries_reconciliation_changed(&el, el.entries[0]));
+    txns[0].splits[0].reconciliation_date = 0;
+
+    // Entry 1 is kept, but entries 4 to 9 go.
+    entries_clear(&el, 5 * 86400);
+    CU_ASSERT_EQUAL(el.count, 4);
+    CU_ASSERT_EQUAL(el.cooked_until, 4);
+    CU_ASSERT(entries_balance_of_reconciled(&el, &res));
+    CU_ASSERT_EQUAL(res.val, 2);
+    CU_ASSERT_PTR_EQUAL(el.last_reconciled, el.entries[1]);
+    for (int i=4; i<10; i++) {
+        entries_create(&el, &txns[i].splits[0], &txns[i]);
+    }
+    CU_ASSERT(entries_cook(&el));
+    CU_ASSERT(entries_balance_of_reconciled(&el, &res));
+    CU_ASSERT_EQUAL(res.val, 2 + 6 + 10);
+    CU_ASSERT_EQUAL(el.last_reconciled->reconciled_balance.val, 2 + 6 + 10);
+
+    entries_deinit(&el);
+    for (int i=0; i<10; i++) {
+        transaction_deinit(&txns[i]);
+    }
+    account_deinit(&a);
+}
+
+static void test_transaction_changed()
+{
+    // Changing amounts after a cook updates balances, cash flows and
+    // reconciled balances without re-cooking, and a later cook of new
+    // entries builds on these updated balances.
+    Currency *USD = currency_get("USD");
+    Account a = {0};
+    account_init(&a, "foo", USD, ACCOUNT_ASSET);
+    Transaction txns[10];
+    EntryList el;
+    entries_init(&el, &a);
+    for (int i=0; i<10; i++) {
+        Transaction *t = &txns[i];
+        transaction_init(t, i == 6 ? TXN_TYPE_BUDGET : TXN_TYPE_NORMAL, (i + 1) * 86400);
+        Split *s = transaction_add_split(t);
+        s->account = &a;
+        amount_set(&s->amount, i + 1, USD);
+        if (i < 8) {
+            entries_create(&el, s, t);
+        }
+    }
+    txns[2].splits[0].reconciliation_date = txns[2].date;
+    CU_ASSERT(entries_cook(&el));
+    CU_ASSERT_FALSE(el.incremental);
+    CU_ASSERT_PTR_NULL(el.balancetree);
+
+    amount_set(&txns[2].splits[0].amount, 13, USD);
+    CU_ASSERT(entries_transaction_changed(&el, &txns[2]));
+    amount_set(&txns[6].splits[0].amount, 17, USD);
+    CU_ASSERT(entries_transaction_changed(&el, &txns[6]));
+    CU_ASSERT(el.incremental);
+    // Not cooked
+    CU_ASSERT_FALSE(entries_transaction_changed(&el, &txns[9]));
+    // Moving in reconciliation order can't be done in place. Nothing changes.
+    txns[4].splits[0].reconciliation_date = 9 * 86400;
+    amount_set(&txns[4].splits[0].amount, 25, USD);
+    CU_ASSERT_FALSE(entries_transaction_changed(&el, &txns[4]));
+    txns[4].splits[0].reconciliation_date = 0;
+    amount_set(&txns[4].splits[0].amount, 5, USD);
+    Amount res;
+    CU_ASSERT(entries_balance(&el, &res, 0, false));
+    CU_ASSERT_EQUAL(res.val, 36 - 7 + 10);
+    CU_ASSERT(entries_balance(&el, &res, 0, true));
+    CU_ASSERT_EQUAL(res.val, 36 + 10 + 10);
+    entries_balance_at(&el, &res, 1, false);
+    CU_ASSERT_EQUAL(res.val, 3);
+    entries_balance_at(&el, &res, 2, false);
+    CU_ASSERT_EQUAL(res.val, 16);
+    res.currency = USD;
+    CU_ASSERT(entries_cash_flow(&el, &res, 2 * 86400, 4 * 86400));
+    CU_ASSERT_EQUAL(res.val, 2 + 13 + 4);
+    CU_ASSERT(entries_balance_of_reconciled(&el, &res));
+    CU_ASSERT_EQUAL(res.val, 13);
+
+    // Cooking the tail keeps us incremental.
+    entries_clear(&el, 8 * 86400);
+    for (int i=7; i<10; i++) {
+        entries_create(&el, &txns[i].splits[0], &txns[i]);
+    }
+    CU_ASSERT(entries_cook(&el));
+    CU_ASSERT(el.incremental);
+    CU_ASSERT(entries_balance(&el, &res, 0, false));
+    CU_ASSERT_EQUAL(res.val, 55 - 7 + 10);
+    // Clearing everything brings us back to our balance columns.
+    entries_clear(&el, 0);
+    CU_ASSERT_FALSE(el.incremental);
+    CU_ASSERT_PTR_NULL(el.balancetree);
+    for (int i=0; i<10; i++) {
+        entries_create(&el, &txns[i].splits[0], &txns[i]);
+    }
+    CU_ASSERT(entries_cook(&el));
+    CU_ASSERT(entries_balance(&el, &res, 0, false));
+    CU_ASSERT_EQUAL(res.val, 55 - 7 + 10);
+
+    entries_deinit(&el);
+    for (int i=0; i<10; i++) {
+        transaction_deinit(&txns[i]);
+    }
+    account_deinit(&a);
+}
+
+static void test_split_outlives_sharing()
+{
+    // An entry taken on shared splits follows its txn to its own copy, even
+    // after the shared copy is freed.
+    Currency *USD = currency_get("USD");
+    Account a = {0};
+    account_init(&a, "foo", USD, ACCOUNT_ASSET);
+    Transaction ref, t1, t2;
+    transaction_init(&ref, TXN_TYPE_NORMAL, 86400);
+    transaction_init(&t1, TXN_TYPE_RECURRENCE, 2 * 86400);
+    transaction_init(&t2, TXN_TYPE_RECURRENCE, 3 * 86400);
+    Split *s = transaction_add_split(&ref);
+    amount_set(&s->amount, 42, USD);
+    s = transaction_add_split(&ref);
+    s->account = &a;
+    amount_set(&s->amount, -42, USD);
+    transaction_share_splits(&t1, &ref);
+    transaction_share_splits(&t2, &ref);
+    Entry e;
+    entry_init(&e, &t1.splits[1], &t1);
+
+    transaction_own_splits(&t1);
+    transaction_deinit(&ref);
+    transaction_deinit(&t2);
+    CU_ASSERT_PTR_EQUAL(entry_split(&e), &t1.splits[1]);
+    Amount amount;
+    amount_set(&amount, 12, USD);
+    CU_ASSERT(entry_amount_set(&e, &amount));
+    CU_ASSERT_EQUAL(t1.splits[1].amount.val, 12);
+    CU_ASSERT_EQUAL(t1.splits[0].amount.val, -12);
+
+    transaction_deinit(&t1);
+    account_deinit(&a);
+}
+
+void test_entry_init()
+{
+    CU_pSuite s;
+
+    s = CU_add_suite("Entry", NULL, NULL);
+    CU_ADD_TEST(s, test_create_many);
+    CU_ADD_TEST(s, test_cash_flow);
+    CU_ADD_TEST(s, test_reconciliation);
+    CU_ADD_TEST(s, test_transaction_changed);
+    CU_ADD_TEST(s, test_split_outlives_sharing);
+}
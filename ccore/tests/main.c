@@ -3,11 +3,14 @@
 #include "../currency.h"
 
 void test_util_init();
+void test_currency_init();
 void test_amount_init();
 void test_account_init();
 void test_transaction_init();
+void test_entry_init();
 void test_recurrence_init();
 void test_undo_init();
+void test_completion_init();
 
 int main()
 {
@@ -15,11 +18,14 @@ int main()
     CU_initialize_registry();
     CU_basic_set_mode(CU_BRM_VERBOSE);
     test_util_init();
+    test_currency_init();
     test_amount_init();
     test_account_init();
     test_transaction_init();
+    test_entry_init();
     test_recurrence_init();
     test_undo_init();
+    test_completion_init();
     CU_basic_run_tests();
     CU_cleanup_registry();
     currency_global_deinit();
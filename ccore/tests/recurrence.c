@@ -1,13 +1,30 @@
 #include <CUnit/CUnit.h>
 #include "../recurrence.h"
+#include "../util.h"
 
 static time_t mkdate(int year, int month, int day)
 {
-    struct tm d = {0};
-    d.tm_year = year - 1900;
-    d.tm_mon = month - 1;
-    d.tm_mday = day;
-    return mktime(&d);
+    return (time_t)days_from_civil(year, month, day) * SECS_IN_DAY;
+}
+
+static void test_civil_days()
+{
+    CU_ASSERT_EQUAL(days_from_civil(1970, 1, 1), 0);
+    CU_ASSERT_EQUAL(days_from_civil(1969, 12, 31), -1);
+    CU_ASSERT_EQUAL(days_from_civil(2000, 3, 1), 11017);
+    int year, month, day;
+    // Round trip over leap days and century boundaries
+    for (int d=-800000; d<=800000; d+=97) {
+        civil_from_days(d, &year, &month, &day);
+        CU_ASSERT_EQUAL_FATAL(days_from_civil(year, month, day), d);
+    }
+    civil_from_days(days_from_civil(2000, 2, 29) + 1, &year, &month, &day);
+    CU_ASSERT_EQUAL(year, 2000);
+    CU_ASSERT_EQUAL(month, 3);
+    CU_ASSERT_EQUAL(day, 1);
+    civil_from_days(days_from_civil(1900, 2, 28) + 1, &year, &month, &day);
+    CU_ASSERT_EQUAL(month, 3);
+    CU_ASSERT_EQUAL(day, 1);
 }
 
 static void test_inc_daily()
@@ -77,16 +94,51 @@ static void test_inc_weekday_last()
     CU_ASSERT_EQUAL(res, mkdate(2019, 2, 26));
 }
 
+static void test_recurrence_dates()
+{
+    time_t dates[10];
+    int index = 0;
+    // 5th thursday of the month, every month: months without one are skipped
+    int count = recurrence_dates(
+        mkdate(2019, 1, 31), REPEAT_WEEKDAY, 1, mkdate(2019, 12, 31), &index,
+        dates, 3);
+    CU_ASSERT_EQUAL(count, 3);
+    CU_ASSERT_EQUAL(dates[0], mkdate(2019, 1, 31));
+    CU_ASSERT_EQUAL(dates[1], mkdate(2019, 5, 30));
+    CU_ASSERT_EQUAL(dates[2], mkdate(2019, 8, 29));
+    // We resume where we stopped
+    count = recurrence_dates(
+        mkdate(2019, 1, 31), REPEAT_WEEKDAY, 1, mkdate(2019, 12, 31), &index,
+        dates, 10);
+    CU_ASSERT_EQUAL(count, 1);
+    CU_ASSERT_EQUAL(dates[0], mkdate(2019, 10, 31));
+    // End is inclusive
+    index = 0;
+    count = recurrence_dates(
+        mkdate(2019, 1, 22), REPEAT_WEEKLY, 2, mkdate(2019, 2, 19), &index,
+        dates, 10);
+    CU_ASSERT_EQUAL(count, 3);
+    CU_ASSERT_EQUAL(dates[2], mkdate(2019, 2, 19));
+    // Nothing when we end before we start
+    index = 0;
+    count = recurrence_dates(
+        mkdate(2019, 1, 22), REPEAT_DAILY, 1, mkdate(2019, 1, 21), &index,
+        dates, 10);
+    CU_ASSERT_EQUAL(count, 0);
+}
+
 void test_recurrence_init()
 {
     CU_pSuite s;
 
     s = CU_add_suite("Recurrence", NULL, NULL);
+    CU_ADD_TEST(s, test_civil_days);
     CU_ADD_TEST(s, test_inc_daily);
     CU_ADD_TEST(s, test_inc_weekly);
     CU_ADD_TEST(s, test_inc_monthly);
     CU_ADD_TEST(s, test_inc_yearly);
     CU_ADD_TEST(s, test_inc_weekday);
     CU_ADD_TEST(s, test_inc_weekday_last);
+    CU_ADD_TEST(s, test_recurrence_dates);
 }
 
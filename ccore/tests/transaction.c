@@ -1,7 +1,10 @@
+#include <stdlib.h>
 #include <CUnit/CUnit.h>
 #include "../transaction.h"
+#include "../transactions.h"
 #include "../accounts.h"
 #include "../currency.h"
+#include "../util.h"
 
 static void test_remove_split()
 {
@@ -113,6 +116,55 @@ static void test_balance()
     accounts_deinit(&al);
 }
 
+static void test_share_splits()
+{
+    Currency *USD = currency_get("USD");
+    AccountList al;
+    accounts_init(&al, USD);
+    Account *a1 = accounts_create(&al);
+    Account *a2 = accounts_create(&al);
+    Transaction ref, t1, t2;
+    transaction_init(&ref, TXN_TYPE_NORMAL, 42);
+    transaction_init(&t1, TXN_TYPE_RECURRENCE, 43);
+    transaction_init(&t2, TXN_TYPE_RECURRENCE, 44);
+    Split *s = transaction_add_split(&ref);
+    s->account = a1;
+    amount_set(&s->amount, 42, USD);
+    transaction_balance(&ref, NULL, false);
+
+    transaction_share_splits(&t1, &ref);
+    transaction_share_splits(&t2, &ref);
+    CU_ASSERT_PTR_EQUAL(t1.splits, ref.splits);
+    CU_ASSERT_PTR_EQUAL(t2.splits, ref.splits);
+    CU_ASSERT_EQUAL(t1.splitcount, 2);
+    CU_ASSERT_EQUAL(*ref.splitsref, 3);
+
+    // Modifying t1 gives it its own copy and leaves the others alone.
+    transaction_reassign_account(&t1, NULL, a2);
+    CU_ASSERT_PTR_NOT_EQUAL(t1.splits, ref.splits);
+    CU_ASSERT_PTR_NULL(t1.splitsref);
+    CU_ASSERT_PTR_EQUAL(t1.splits[1].account, a2);
+    CU_ASSERT_PTR_NULL(ref.splits[1].account);
+    CU_ASSERT_PTR_NULL(t2.splits[1].account);
+    CU_ASSERT_EQUAL(*ref.splitsref, 2);
+
+    // Splits we pass are followed to the copy.
+    transaction_balance(&t2, &ref.splits[0], true);
+    CU_ASSERT_PTR_NOT_EQUAL(t2.splits, ref.splits);
+    CU_ASSERT_EQUAL(t2.splits[1].amount.val, -42);
+
+    // We're the last one holding these splits, no need to copy.
+    Split *splits = ref.splits;
+    transaction_own_splits(&ref);
+    CU_ASSERT_PTR_NULL(ref.splitsref);
+    CU_ASSERT_PTR_EQUAL(ref.splits, splits);
+
+    transaction_deinit(&t1);
+    transaction_deinit(&t2);
+    transaction_deinit(&ref);
+    accounts_deinit(&al);
+}
+
 static void test_affected_accounts()
 {
     Currency *USD = currency_get("USD");
@@ -137,6 +189,184 @@ static void test_affected_accounts()
     CU_ASSERT_PTR_NULL(affected[2]);
 }
 
+static void test_list_stays_sorted()
+{
+    // TransactionList keeps its txns sorted by (date, position), even when
+    // dates change behind its back.
+    TransactionList tl;
+    transactions_init(&tl);
+    Transaction t[4];
+    transaction_init(&t[0], TXN_TYPE_NORMAL, 3);
+    transaction_init(&t[1], TXN_TYPE_NORMAL, 1);
+    transaction_init(&t[2], TXN_TYPE_NORMAL, 3);
+    transaction_init(&t[3], TXN_TYPE_NORMAL, 2);
+    for (int i=0; i<4; i++) {
+        transactions_add(&tl, &t[i], false);
+    }
+    CU_ASSERT_PTR_EQUAL(tl.txns[0], &t[1]);
+    CU_ASSERT_PTR_EQUAL(tl.txns[1], &t[3]);
+    CU_ASSERT_PTR_EQUAL(tl.txns[2], &t[0]);
+    CU_ASSERT_PTR_EQUAL(tl.txns[3], &t[2]);
+    // Non-positioned adds end up last on their date
+    CU_ASSERT_EQUAL(t[2].position, 1);
+    Transaction **at3 = transactions_at_date(&tl, 3);
+    CU_ASSERT_PTR_EQUAL(at3[0], &t[0]);
+    CU_ASSERT_PTR_EQUAL(at3[1], &t[2]);
+    CU_ASSERT_PTR_NULL(at3[2]);
+    free(at3);
+    CU_ASSERT_PTR_NULL(transactions_at_date(&tl, 4));
+
+    transactions_move_before(&tl, &t[2], &t[0]);
+    CU_ASSERT_PTR_EQUAL(tl.txns[2], &t[2]);
+    CU_ASSERT_PTR_EQUAL(tl.txns[3], &t[0]);
+
+    t[1].date = 4;
+    transactions_order_changed();
+    CU_ASSERT_EQUAL(transactions_find(&tl, &t[1]), 3);
+    CU_ASSERT_PTR_EQUAL(tl.txns[0], &t[3]);
+    CU_ASSERT(transactions_remove(&tl, &t[3]));
+    CU_ASSERT_EQUAL(transactions_find(&tl, &t[3]), -1);
+    CU_ASSERT_EQUAL(tl.count, 3);
+    CU_ASSERT_PTR_EQUAL(tl.txns[0], &t[2]);
+    transactions_deinit(&tl);
+    for (int i=0; i<4; i++) {
+        transaction_deinit(&t[i]);
+    }
+}
+
+static void test_list_remove_many()
+{
+    TransactionList tl;
+    transactions_init(&tl);
+    Transaction t[5];
+    for (int i=0; i<5; i++) {
+        transaction_init(&t[i], TXN_TYPE_NORMAL, i);
+        transactions_add(&tl, &t[i], false);
+    }
+    // Duplicates and txns that aren't in the list are ignored.
+    Transaction other;
+    transaction_init(&other, TXN_TYPE_NORMAL, 2);
+    Transaction *toremove[] = {&t[3], &other, &t[1], &t[3], NULL};
+    CU_ASSERT_EQUAL(transactions_remove_many(&tl, toremove), 2);
+    CU_ASSERT_EQUAL(tl.count, 3);
+    CU_ASSERT_PTR_EQUAL(tl.txns[0], &t[0]);
+    CU_ASSERT_PTR_EQUAL(tl.txns[1], &t[2]);
+    CU_ASSERT_PTR_EQUAL(tl.txns[2], &t[4]);
+    CU_ASSERT_EQUAL(transactions_find(&tl, &t[1]), -1);
+    CU_ASSERT_EQUAL(transactions_find(&tl, &t[4]), 2);
+    transactions_deinit(&tl);
+    for (int i=0; i<5; i++) {
+        transaction_deinit(&t[i]);
+    }
+    transaction_deinit(&other);
+}
+
+static void test_list_descriptions()
+{
+    // Descriptions come stripped, most recently modified first, without
+    // duplicates or blank strings, and follow changes we're notified of.
+    TransactionList tl;
+    transactions_init(&tl);
+    const char *descs[] = {"foo", "bar", " ", "foo ", "baz"};
+    Transaction t[5];
+    for (int i=0; i<5; i++) {
+        transaction_init(&t[i], TXN_TYPE_NORMAL, 5 - i);
+        t[i].mtime = i;
+        strset(&t[i].description, descs[i]);
+        transactions_add(&tl, &t[i], false);
+    }
+    char **res = transactions_descriptions(&tl);
+    CU_ASSERT_STRING_EQUAL(res[0], "baz");
+    CU_ASSERT_STRING_EQUAL(res[1], "foo");
+    CU_ASSERT_STRING_EQUAL(res[2], "bar");
+    CU_ASSERT_PTR_NULL(res[3]);
+    free(res);
+    t[1].mtime = 42;
+    transactions_changed(&tl, &t[1]);
+    res = transactions_descriptions(&tl);
+    CU_ASSERT_STRING_EQUAL(res[0], "bar");
+    CU_ASSERT_STRING_EQUAL(res[1], "baz");
+    CU_ASSERT_STRING_EQUAL(res[2], "foo");
+    CU_ASSERT_PTR_NULL(res[3]);
+    free(res);
+    CU_ASSERT(transactions_remove(&tl, &t[1]));
+    res = transactions_descriptions(&tl);
+    CU_ASSERT_STRING_EQUAL(res[0], "baz");
+    CU_ASSERT_STRING_EQUAL(res[1], "foo");
+    CU_ASSERT_PTR_NULL(res[2]);
+    free(res);
+    // When its most recent holder goes away, "foo" falls back to the next one.
+    unsigned int version = tl.descriptions.version;
+    strset(&t[3].description, "bar");
+    transactions_changed(&tl, &t[3]);
+    CU_ASSERT_NOT_EQUAL(tl.descriptions.version, version);
+    res = transactions_descriptions(&tl);
+    CU_ASSERT_STRING_EQUAL(res[0], "baz");
+    CU_ASSERT_STRING_EQUAL(res[1], "bar");
+    CU_ASSERT_STRING_EQUAL(res[2], "foo");
+    CU_ASSERT_PTR_NULL(res[3]);
+    free(res);
+    // Completions follow along.
+    const char **found = completion_find(&tl.descriptions.completion, "BA");
+    CU_ASSERT_STRING_EQUAL(found[0], "baz");
+    CU_ASSERT_STRING_EQUAL(found[1], "bar");
+    CU_ASSERT_PTR_NULL(found[2]);
+    free(found);
+    // Changes that don't move anything leave the list alone.
+    version = tl.descriptions.version;
+    transactions_changed(&tl, &t[0]);
+    CU_ASSERT_EQUAL(tl.descriptions.version, version);
+    transactions_deinit(&tl);
+    for (int i=0; i<5; i++) {
+        transaction_deinit(&t[i]);
+    }
+}
+
+static void test_list_account_names()
+{
+    // Account names come most recently modified first, in split order within
+    // a txn, and skip inactive accounts.
+    Currency *USD = currency_get("USD");
+    Account a1, a2, a3;
+    account_init(&a1, "a1", USD, ACCOUNT_ASSET);
+    account_init(&a2, "a2", USD, ACCOUNT_ASSET);
+    account_init(&a3, "a3", USD, ACCOUNT_ASSET);
+    TransactionList tl;
+    transactions_init(&tl);
+    Transaction t[2];
+    transaction_init(&t[0], TXN_TYPE_NORMAL, 1);
+    transaction_resize_splits(&t[0], 2);
+    t[0].splits[0].account = &a1;
+    t[0].splits[1].account = &a2;
+    t[0].mtime = 1;
+    transaction_init(&t[1], TXN_TYPE_NORMAL, 2);
+    transaction_resize_splits(&t[1], 2);
+    t[1].splits[0].account = &a3;
+    t[1].splits[1].account = &a1;
+    t[1].mtime = 2;
+    transactions_add(&tl, &t[0], false);
+    transactions_add(&tl, &t[1], false);
+    char **res = transactions_account_names(&tl);
+    CU_ASSERT_STRING_EQUAL(res[0], "a3");
+    CU_ASSERT_STRING_EQUAL(res[1], "a1");
+    CU_ASSERT_STRING_EQUAL(res[2], "a2");
+    CU_ASSERT_PTR_NULL(res[3]);
+    free(res);
+    a3.inactive = true;
+    transactions_reassign_account(&tl, &a1, &a2);
+    res = transactions_account_names(&tl);
+    CU_ASSERT_STRING_EQUAL(res[0], "a2");
+    CU_ASSERT_PTR_NULL(res[1]);
+    free(res);
+    transactions_deinit(&tl);
+    for (int i=0; i<2; i++) {
+        transaction_deinit(&t[i]);
+    }
+    account_deinit(&a1);
+    account_deinit(&a2);
+    account_deinit(&a3);
+}
+
 void test_transaction_init()
 {
     CU_pSuite s;
@@ -145,5 +375,10 @@ void test_transaction_init()
     CU_ADD_TEST(s, test_remove_split);
     CU_ADD_TEST(s, test_balance_currencies);
     CU_ADD_TEST(s, test_balance);
+    CU_ADD_TEST(s, test_share_splits);
     CU_ADD_TEST(s, test_affected_accounts);
+    CU_ADD_TEST(s, test_list_stays_sorted);
+    CU_ADD_TEST(s, test_list_remove_many);
+    CU_ADD_TEST(s, test_list_descriptions);
+    CU_ADD_TEST(s, test_list_account_names);
 }
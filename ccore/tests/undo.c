@@ -1,6 +1,7 @@
 #include <CUnit/CUnit.h>
 #include "../accounts.h"
 #include "../undo.h"
+#include "../util.h"
 
 static void test_string_ownership()
 {
@@ -26,11 +27,50 @@ static void test_string_ownership()
     CU_ASSERT_STRING_EQUAL(a->name, "foo"); // no segfault
 }
 
+static void test_compact_txn()
+{
+    /* After compaction, only changed fields are kept and swapped */
+    AccountList al = {0};
+    TransactionList tl = {0};
+    Currency *CAD = currency_get("CAD");
+    accounts_init(&al, CAD);
+    transactions_init(&tl);
+    Account *a = accounts_create(&al);
+    account_init(a, "foo", CAD, ACCOUNT_ASSET);
+    Transaction t = {0};
+    transaction_init(&t, TXN_TYPE_NORMAL, 42);
+    strset(&t.description, "desc");
+    strset(&t.payee, "payee");
+    Split *s = transaction_add_split(&t);
+    s->account = a;
+    amount_set(&s->amount, 12, CAD);
+    UndoStep us = {0};
+    Transaction *changed_txns[2] = {&t, NULL};
+    undostep_init(&us, NULL, NULL, NULL, NULL, NULL, changed_txns);
+    strset(&t.payee, "other");
+    undostep_compact(&us);
+    ChangedTransaction *c = &us.changed_txns[0];
+    CU_ASSERT_EQUAL(c->fields, TXN_FIELD_PAYEE);
+    CU_ASSERT_PTR_NULL(c->copy.description);
+    CU_ASSERT_PTR_NULL(c->copy.splits);
+    undostep_undo(&us, &al, &tl);
+    CU_ASSERT_STRING_EQUAL(t.payee, "payee");
+    CU_ASSERT_STRING_EQUAL(t.description, "desc");
+    CU_ASSERT_EQUAL(t.splitcount, 1);
+    CU_ASSERT_EQUAL(t.splits[0].amount.val, 12);
+    undostep_redo(&us, &al, &tl);
+    CU_ASSERT_STRING_EQUAL(t.payee, "other");
+    CU_ASSERT_EQUAL(t.date, 42);
+    undostep_deinit(&us);
+    transaction_deinit(&t);
+}
+
 void test_undo_init()
 {
     CU_pSuite s;
 
     s = CU_add_suite("Undo", NULL, NULL);
     CU_ADD_TEST(s, test_string_ownership);
+    CU_ADD_TEST(s, test_compact_txn);
 }
 
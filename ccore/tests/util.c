@@ -14,6 +14,16 @@ static void test_strstrip()
     CU_ASSERT_TRUE_FATAL(strstrip(&dst, "  "));
     CU_ASSERT_STRING_EQUAL(dst, "");
     free(dst);
+
+    CU_ASSERT_PTR_NULL(strstripped(NULL));
+    CU_ASSERT_PTR_NULL(strstripped(""));
+    CU_ASSERT_PTR_NULL(strstripped("  "));
+    dst = strstripped("foo");
+    CU_ASSERT_STRING_EQUAL(dst, "foo");
+    free(dst);
+    dst = strstripped(" foo ");
+    CU_ASSERT_STRING_EQUAL(dst, "foo");
+    free(dst);
 }
 
 void test_util_init()
@@ -27,6 +27,44 @@ _txn_reindex(Transaction *txn)
     }
 }
 
+// Drops our splits, freeing them unless other txns share them.
+static void
+_txn_release_splits(Transaction *txn)
+{
+    if (txn->splitsref != NULL) {
+        (*txn->splitsref)--;
+        bool shared = *txn->splitsref > 0;
+        if (!shared) {
+            free(txn->splitsref);
+        }
+        txn->splitsref = NULL;
+        if (shared) {
+            txn->splits = NULL;
+            txn->splitcount = 0;
+            return;
+        }
+    }
+    for (unsigned int i=0; i<txn->splitcount; i++) {
+        split_deinit(&txn->splits[i]);
+    }
+    free(txn->splits);
+    txn->splits = NULL;
+    txn->splitcount = 0;
+}
+
+// Calls transaction_own_splits() and returns where `split` is afterwards if
+// it's one of ours.
+static Split*
+_txn_own_split(Transaction *txn, Split *split)
+{
+    if (txn->splitsref == NULL || split == NULL) {
+        return split;
+    }
+    bool ours = _txn_check_ownership(txn, split);
+    transaction_own_splits(txn);
+    return ours ? &txn->splits[split->index] : split;
+}
+
 // Currencies involved in this txn. Null terminated.
 // Caller is responsible for freeing list
 Currency**
@@ -94,6 +132,7 @@ _txn_assign_imbalance(
     const Amount *imbalance,
     int except_index)
 {
+    transaction_own_splits(txn);
     Split *target = _txn_find_unassigned(txn, imbalance->currency, except_index);
     if (target == NULL) {
         // no existing target, let's create one
@@ -122,6 +161,7 @@ transaction_init(Transaction *txn, TransactionType type, time_t date)
     txn->mtime = 0;
     txn->splits = malloc(0);
     txn->splitcount = 0;
+    txn->splitsref = NULL;
     txn->affected_accounts = NULL;
 
     txn->ref = NULL;
@@ -135,7 +175,7 @@ transaction_deinit(Transaction *txn)
     strfree(&txn->payee);
     strfree(&txn->checkno);
     strfree(&txn->notes);
-    free(txn->splits);
+    _txn_release_splits(txn);
     free(txn->affected_accounts);
 }
 
@@ -220,6 +260,7 @@ transaction_assign_imbalance(Transaction *txn, Split *target)
     if (target->account == NULL) {
         return false;
     }
+    target = _txn_own_split(txn, target);
     // get rid of zero-splits
     transaction_balance(txn, target, false);
     if (target->amount.currency == NULL) {
@@ -299,6 +340,7 @@ transaction_balance(
     if (txn->splitcount == 0) {
         return;
     }
+    strong_split = _txn_own_split(txn, strong_split);
     if (txn->splitcount == 2 && strong_split != NULL) {
         Split *weak = &txn->splits[0];
         if (weak == strong_split) {
@@ -379,6 +421,9 @@ transaction_copy(Transaction *dst, Transaction *src)
     }
     dst->position = src->position;
     dst->mtime = src->mtime;
+    if (dst->splitsref != NULL) {
+        _txn_release_splits(dst);
+    }
     dst->splitcount = src->splitcount;
     dst->splits = malloc(sizeof(Split) * dst->splitcount);
     memset(dst->splits, 0, sizeof(Split) * dst->splitcount);
@@ -429,6 +474,7 @@ transaction_mct_balance(Transaction *txn, Currency *new_split_currency)
         bal.val += a.val;
     }
     if (bal.val != 0) {
+        transaction_own_splits(txn);
         Split *found = NULL;
         for (unsigned int i=0; i<txn->splitcount; i++) {
             Split *s = &txn->splits[i];
@@ -457,6 +503,7 @@ transaction_move_split(Transaction *txn, Split *split, unsigned int newindex)
     if (newindex == split->index) {
         return true;
     }
+    split = _txn_own_split(txn, split);
 
     unsigned int index = split->index;
     Split copy;
@@ -479,6 +526,28 @@ transaction_move_split(Transaction *txn, Split *split, unsigned int newindex)
     return true;
 }
 
+void
+transaction_own_splits(Transaction *txn)
+{
+    if (txn->splitsref == NULL) {
+        return;
+    }
+    if (*txn->splitsref == 1) {
+        // Everyone else let go of our splits, they're ours now.
+        free(txn->splitsref);
+        txn->splitsref = NULL;
+        return;
+    }
+    Split *splits = calloc(txn->splitcount, sizeof(Split));
+    for (unsigned int i=0; i<txn->splitcount; i++) {
+        split_copy(&splits[i], &txn->splits[i]);
+        splits[i].index = i;
+    }
+    (*txn->splitsref)--;
+    txn->splitsref = NULL;
+    txn->splits = splits;
+}
+
 void
 transaction_print(const Transaction *txn)
 {
@@ -502,9 +571,9 @@ transaction_reassign_account(
 {
     bool res = false;
     for (unsigned int i=0; i<txn->splitcount; i++) {
-        Split *s = &txn->splits[i];
-        if (s->account == account) {
-            split_account_set(s, to);
+        if (txn->splits[i].account == account) {
+            transaction_own_splits(txn);
+            split_account_set(&txn->splits[i], to);
             res = true;
         }
     }
@@ -517,6 +586,7 @@ transaction_remove_split(Transaction *txn, Split *split)
     if (!_txn_check_ownership(txn, split)) {
         return false;
     }
+    split = _txn_own_split(txn, split);
     unsigned int count = txn->splitcount;
     unsigned int index = split->index;
     if (index < count-1) {
@@ -539,6 +609,7 @@ transaction_resize_splits(Transaction *txn, unsigned int newsize)
     if (newsize == txn->splitcount) {
         return;
     }
+    transaction_own_splits(txn);
     txn->splits = realloc(txn->splits, sizeof(Split) * newsize);
     for (unsigned int i=txn->splitcount; i<newsize; i++) {
         split_init(&txn->splits[i], NULL, amount_zero(), i);
@@ -546,3 +617,19 @@ transaction_resize_splits(Transaction *txn, unsigned int newsize)
     txn->splitcount = newsize;
 }
 
+void
+transaction_share_splits(Transaction *dst, Transaction *src)
+{
+    if (dst == src || dst->splits == src->splits) {
+        return;
+    }
+    _txn_release_splits(dst);
+    if (src->splitsref == NULL) {
+        src->splitsref = malloc(sizeof(unsigned int));
+        *src->splitsref = 1;
+    }
+    (*src->splitsref)++;
+    dst->splitsref = src->splitsref;
+    dst->splits = src->splits;
+    dst->splitcount = src->splitcount;
+}
@@ -30,6 +30,16 @@ typedef enum {
  *
  * Other than holding a reference to its recurrence, it behaves pretty much
  * like a normal transaction.
+ *
+ * SHARED SPLITS
+ *
+ * A schedule can have a whole lot of spawns, all with the same splits. Rather
+ * than having each of them hold a copy of those splits, we can have them share
+ * a single split array with transaction_share_splits(). This sharing is
+ * copy-on-write: all functions below that modify splits first call
+ * transaction_own_splits(), which gives the txn its own copy. Pointers to
+ * shared splits are thus invalidated by such modifications, but their index
+ * stays the same.
  */
 typedef struct _Transaction {
     TransactionType type;
@@ -54,6 +64,9 @@ typedef struct _Transaction {
     // list is never over-allocated. This means that all splits are "valid".
     Split *splits;
     unsigned int splitcount;
+    // When not NULL, `splits` is shared with other txns (see
+    // transaction_share_splits()) and this is the number of txns sharing it.
+    unsigned int *splitsref;
     // Used to hold the result of transaction_affected_accounts(). Is
     // reinitialized on each call and freed on transaction_deinit().
     Account **affected_accounts;
@@ -211,6 +224,14 @@ transaction_mct_balance(Transaction *txn, Currency *new_split_currency);
 bool
 transaction_move_split(Transaction *txn, Split *split, unsigned int newindex);
 
+/* Makes sure that `txn` has its own copy of its splits.
+ *
+ * If our splits are shared, copy them and stop sharing. Pointers to our
+ * splits are invalidated.
+ */
+void
+transaction_own_splits(Transaction *txn);
+
 // For debugging
 void
 transaction_print(const Transaction *txn);
@@ -235,3 +256,10 @@ transaction_remove_split(Transaction *txn, Split *split);
 void
 transaction_resize_splits(Transaction *txn, unsigned int newsize);
 
+/* Have `dst` share `src`'s splits instead of holding its own.
+ *
+ * `dst`'s former splits are released. From then on, both `dst` and `src`
+ * copy their splits before modifying them (see "SHARED SPLITS").
+ */
+void
+transaction_share_splits(Transaction *dst, Transaction *src);
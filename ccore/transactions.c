@@ -1,5 +1,12 @@
 #include <stdlib.h>
+#include <string.h>
 #include "transactions.h"
+#include "util.h"
+
+#define TRANSACTIONS_MIN_CAPACITY 64
+
+// Incremented by transactions_order_changed()
+static unsigned int g_order_generation = 0;
 
 /* Private */
 static int
@@ -18,44 +25,401 @@ _txn_cmp_key(const void *a, const void *b)
 }
 
 static int
-_txn_cmp_mtime(const void *a, const void *b)
+_txn_cmp(const Transaction *t1, const Transaction *t2)
 {
-    Transaction *t1 = *((Transaction **)a);
-    Transaction *t2 = *((Transaction **)b);
+    return _txn_cmp_key(&t1, &t2);
+}
+
+/* Returns the index of the first txn that sorts after `txn` (if `after` is
+ * true) or that doesn't sort before it (if `after` is false).
+ */
+static unsigned int
+_transactions_bisect(const TransactionList *txns, const Transaction *txn, bool after)
+{
+    unsigned int low = 0;
+    unsigned int high = txns->count;
+    while (low < high) {
+        unsigned int mid = low + (high - low) / 2;
+        int cmp = _txn_cmp(txns->txns[mid], txn);
+        if (cmp < 0 || (after && cmp == 0)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+// Returns the index of the first txn that has a date >= `date`.
+static unsigned int
+_transactions_bisect_date(const TransactionList *txns, time_t date)
+{
+    unsigned int low = 0;
+    unsigned int high = txns->count;
+    while (low < high) {
+        unsigned int mid = low + (high - low) / 2;
+        if (txns->txns[mid]->date < date) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static void
+_transactions_ensure_sorted(TransactionList *txns)
+{
+    if (txns->generation == g_order_generation) {
+        return;
+    }
+    for (unsigned int i=1; i<txns->count; i++) {
+        if (_txn_cmp(txns->txns[i-1], txns->txns[i]) > 0) {
+            qsort(txns->txns, txns->count, sizeof(Transaction*), _txn_cmp_key);
+            break;
+        }
+    }
+    txns->generation = g_order_generation;
+}
+
+// Removes, from `txns`, txns that aren't in `members` anymore.
+static void
+_transactions_compact(TransactionList *txns)
+{
+    unsigned int kept = 0;
+    for (unsigned int i=0; i<txns->count; i++) {
+        if (g_hash_table_contains(txns->members, txns->txns[i])) {
+            txns->txns[kept] = txns->txns[i];
+            kept++;
+        }
+    }
+    txns->count = kept;
+}
+
+/* MRUIndex */
+typedef struct {
+    // Owned copy if our index holds strings.
+    void *value;
+    // Key of our most recent holder.
+    MRUKey key;
+    // Our place in MRUIndex.order
+    GSequenceIter *order;
+} MRUValue;
+
+typedef struct {
+    MRUValue *value;
+    MRUKey key;
+    // A probe sorts after all holders of its value. Only used for lookups.
+    bool probe;
+} MRUHolder;
+
+// What we indexed of a txn. Each field is a holder in one of our MRUIndex.
+typedef struct {
+    // NULL when empty
+    GSequenceIter *description;
+    // NULL when empty
+    GSequenceIter *payee;
+    // NULL-terminated
+    GSequenceIter **accounts;
+} TxnIndex;
 
-    if (t1->mtime != t2->mtime) {
-        return t1->mtime < t2->mtime ? -1 : 1;
+static int
+_mrukey_cmp(const MRUKey *k1, const MRUKey *k2)
+{
+    if (k1->mtime != k2->mtime) {
+        return k1->mtime < k2->mtime ? -1 : 1;
+    }
+    if (k1->seq != k2->seq) {
+        return k1->seq < k2->seq ? -1 : 1;
     }
     return 0;
 }
 
-// TODO: re-instate this. seems to be causing problems
-// deduplicates *in place*. slist is NULL-terminated after and before.
-/*static void                                                      */
-/*_deduplicate_strings(char **slist)                               */
-/*{                                                                */
-/*    GHashTable *seen = g_hash_table_new(g_str_hash, g_str_equal);*/
-/*    char **iter = slist;                                         */
-/*    char **replace_iter = slist;                                 */
-/*    while (*iter != NULL) {                                      */
-/*        char *s = *iter;                                         */
-/*        if ((s[0] != '\0') && !g_hash_table_contains(seen, &s)) {*/
-/*            *replace_iter = s;                                   */
-/*            g_hash_table_add(seen, &s);                          */
-/*            replace_iter++;                                      */
-/*        }                                                        */
-/*        iter++;                                                  */
-/*    }                                                            */
-/*    *replace_iter = NULL;                                        */
-/*    g_hash_table_destroy(seen);                                  */
-/*}                                                                */
+static gint
+_mruholder_cmp(gconstpointer a, gconstpointer b, gpointer data)
+{
+    const MRUHolder *h1 = a;
+    const MRUHolder *h2 = b;
+
+    if (h1->value != h2->value) {
+        return h1->value < h2->value ? -1 : 1;
+    }
+    if (h1->probe) {
+        return h2->probe ? 0 : 1;
+    }
+    if (h2->probe) {
+        return -1;
+    }
+    return _mrukey_cmp(&h1->key, &h2->key);
+}
+
+// Most recent first
+static gint
+_mruvalue_cmp(gconstpointer a, gconstpointer b, gpointer data)
+{
+    const MRUValue *v1 = a;
+    const MRUValue *v2 = b;
+    return _mrukey_cmp(&v2->key, &v1->key);
+}
+
+static CompletionRank
+_mrukey_rank(MRUKey key)
+{
+    CompletionRank res = {-(int64_t)key.mtime, -(int64_t)key.seq};
+    return res;
+}
+
+static void
+_mruvalue_free_string(gpointer data)
+{
+    MRUValue *v = data;
+    free(v->value);
+    free(v);
+}
+
+static void
+_mru_init(MRUIndex *index, bool strings)
+{
+    index->strings = strings;
+    if (strings) {
+        index->values = g_hash_table_new_full(
+            g_str_hash, g_str_equal, NULL, _mruvalue_free_string);
+    } else {
+        index->values = g_hash_table_new_full(
+            g_direct_hash, g_direct_equal, NULL, free);
+    }
+    index->holders = g_sequence_new(free);
+    index->order = g_sequence_new(NULL);
+    index->version = 0;
+    if (strings) {
+        completion_init(&index->completion);
+    }
+}
+
+static void
+_mru_deinit(MRUIndex *index)
+{
+    g_sequence_free(index->holders);
+    g_sequence_free(index->order);
+    g_hash_table_destroy(index->values);
+    if (index->strings) {
+        completion_deinit(&index->completion);
+    }
+}
+
+// Follows a change of `v`'s key: re-ranks its completion and moves it in
+// `order` if it has to.
+static void
+_mru_reorder(MRUIndex *index, MRUValue *v)
+{
+    if (index->strings) {
+        completion_set(&index->completion, v->value, _mrukey_rank(v->key));
+    }
+    if (!g_sequence_iter_is_begin(v->order)) {
+        MRUValue *prev = g_sequence_get(g_sequence_iter_prev(v->order));
+        if (_mruvalue_cmp(prev, v, NULL) > 0) {
+            g_sequence_sort_changed(v->order, _mruvalue_cmp, NULL);
+            index->version++;
+            return;
+        }
+    }
+    GSequenceIter *next = g_sequence_iter_next(v->order);
+    if (!g_sequence_iter_is_end(next)) {
+        if (_mruvalue_cmp(v, g_sequence_get(next), NULL) > 0) {
+            g_sequence_sort_changed(v->order, _mruvalue_cmp, NULL);
+            index->version++;
+        }
+    }
+}
+
+// Adds a holder of `value` and returns it. Blank strings aren't indexed and
+// give NULL.
+static GSequenceIter*
+_mru_add(MRUIndex *index, const void *value, MRUKey key)
+{
+    char *stripped = NULL;
+    if (index->strings) {
+        stripped = strstripped(value);
+        if (stripped == NULL) {
+            return NULL;
+        }
+        value = stripped;
+    }
+    MRUValue *v = g_hash_table_lookup(index->values, value);
+    if (v == NULL) {
+        v = malloc(sizeof(MRUValue));
+        v->value = (void *)value;
+        // Now owned by `v`
+        stripped = NULL;
+        v->order = NULL;
+        g_hash_table_insert(index->values, v->value, v);
+    }
+    free(stripped);
+    MRUHolder *h = malloc(sizeof(MRUHolder));
+    h->value = v;
+    h->key = key;
+    h->probe = false;
+    GSequenceIter *res = g_sequence_insert_sorted(
+        index->holders, h, _mruholder_cmp, NULL);
+    if (v->order == NULL) {
+        v->key = key;
+        v->order = g_sequence_insert_sorted(
+            index->order, v, _mruvalue_cmp, NULL);
+        index->version++;
+        if (index->strings) {
+            completion_set(&index->completion, v->value, _mrukey_rank(key));
+        }
+    } else if (_mrukey_cmp(&key, &v->key) > 0) {
+        v->key = key;
+        _mru_reorder(index, v);
+    }
+    return res;
+}
+
+// Removes `holder`. Its value then falls back to its next most recent holder,
+// if any.
+static void
+_mru_remove(MRUIndex *index, GSequenceIter *holder)
+{
+    if (holder == NULL) {
+        return;
+    }
+    MRUValue *v = ((MRUHolder *)g_sequence_get(holder))->value;
+    g_sequence_remove(holder);
+    MRUHolder probe = {v, {0, 0}, true};
+    GSequenceIter *iter = g_sequence_search(
+        index->holders, &probe, _mruholder_cmp, NULL);
+    MRUHolder *last = NULL;
+    if (!g_sequence_iter_is_begin(iter)) {
+        last = g_sequence_get(g_sequence_iter_prev(iter));
+        if (last->value != v) {
+            last = NULL;
+        }
+    }
+    if (last == NULL) {
+        if (index->strings) {
+            completion_remove(&index->completion, v->value);
+        }
+        g_sequence_remove(v->order);
+        g_hash_table_remove(index->values, v->value);
+        index->version++;
+    } else if (_mrukey_cmp(&last->key, &v->key) != 0) {
+        v->key = last->key;
+        _mru_reorder(index, v);
+    }
+}
+
+// Returns our values, most recent first, in a NULL-terminated list that must
+// be freed with free().
+static void**
+_mru_list(MRUIndex *index)
+{
+    void **res = malloc(
+        sizeof(void*) * (g_sequence_get_length(index->order) + 1));
+    void **dst = res;
+    GSequenceIter *iter = g_sequence_get_begin_iter(index->order);
+    while (!g_sequence_iter_is_end(iter)) {
+        *dst = ((MRUValue *)g_sequence_get(iter))->value;
+        dst++;
+        iter = g_sequence_iter_next(iter);
+    }
+    *dst = NULL;
+    return res;
+}
+
+static void
+_txnindex_free(gpointer data)
+{
+    TxnIndex *ti = data;
+    free(ti->accounts);
+    free(ti);
+}
+
+static void
+_transactions_index(TransactionList *txns, Transaction *txn)
+{
+    TxnIndex *ti = malloc(sizeof(TxnIndex));
+    MRUKey key = {txn->mtime, txns->seq++};
+    ti->description = _mru_add(&txns->descriptions, txn->description, key);
+    ti->payee = _mru_add(&txns->payees, txn->payee, key);
+    Account **accounts = transaction_affected_accounts(txn);
+    int count = 0;
+    while (accounts[count] != NULL) {
+        count++;
+    }
+    ti->accounts = malloc(sizeof(GSequenceIter*) * (count + 1));
+    // The first accounts of a txn come first in our list.
+    for (int i=count-1; i>=0; i--) {
+        key.seq = txns->seq++;
+        ti->accounts[i] = _mru_add(&txns->accounts, accounts[i], key);
+    }
+    ti->accounts[count] = NULL;
+    g_hash_table_insert(txns->members, txn, ti);
+}
+
+// Removes the holders of `ti` from our indexes, then frees it.
+static void
+_transactions_unindex_holders(TransactionList *txns, TxnIndex *ti)
+{
+    _mru_remove(&txns->descriptions, ti->description);
+    _mru_remove(&txns->payees, ti->payee);
+    for (GSequenceIter **iter=ti->accounts; *iter != NULL; iter++) {
+        _mru_remove(&txns->accounts, *iter);
+    }
+    _txnindex_free(ti);
+}
+
+/* Removes `txn` from `members` and from our indexes, but not from `txns`.
+ *
+ * Returns false if `txn` isn't ours.
+ */
+static bool
+_transactions_unindex(TransactionList *txns, Transaction *txn)
+{
+    TxnIndex *ti = g_hash_table_lookup(txns->members, txn);
+    if (ti == NULL) {
+        return false;
+    }
+    g_hash_table_steal(txns->members, txn);
+    _transactions_unindex_holders(txns, ti);
+    return true;
+}
+
+// deduplicates *in place*. slist is NULL-terminated after and before. Empty
+// strings are removed.
+static void
+_deduplicate_strings(char **slist)
+{
+    GHashTable *seen = g_hash_table_new(g_str_hash, g_str_equal);
+    char **iter = slist;
+    char **replace_iter = slist;
+    while (*iter != NULL) {
+        char *s = *iter;
+        if ((s[0] != '\0') && !g_hash_table_contains(seen, s)) {
+            *replace_iter = s;
+            g_hash_table_add(seen, s);
+            replace_iter++;
+        }
+        iter++;
+    }
+    *replace_iter = NULL;
+    g_hash_table_destroy(seen);
+}
 
 /* Public */
 void
 transactions_init(TransactionList *txns)
 {
     txns->count = 0;
+    txns->capacity = 0;
     txns->txns = NULL;
+    txns->generation = g_order_generation;
+    txns->members = g_hash_table_new_full(
+        g_direct_hash, g_direct_equal, NULL, _txnindex_free);
+    _mru_init(&txns->descriptions, true);
+    _mru_init(&txns->payees, true);
+    _mru_init(&txns->accounts, false);
+    txns->seq = 0;
 }
 
 void
@@ -67,128 +431,132 @@ transactions_deinit(TransactionList *txns)
     /*    free(txn);                       */
     /*}                                    */
     free(txns->txns);
+    // Our holders go with their MRUIndex.
+    g_hash_table_destroy(txns->members);
+    _mru_deinit(&txns->descriptions);
+    _mru_deinit(&txns->payees);
+    _mru_deinit(&txns->accounts);
+}
+
+void
+transactions_order_changed(void)
+{
+    g_order_generation++;
 }
 
 char**
-transactions_account_names(const TransactionList *txns)
-{
-    Transaction **bymtime = malloc(sizeof(Transaction*) * txns->count);
-    memcpy(bymtime, txns->txns, sizeof(Transaction*) * txns->count);
-    qsort(bymtime, txns->count, sizeof(Transaction*), _txn_cmp_mtime);
-
-    // we don't know our upper count limit beforehand. Let's try with
-    // txns->count and realloc if needed.
-    int count = txns->count;
-    char **res = malloc(sizeof(char*) * count);
-    int current = 0;
-    for (int i=txns->count-1; i>=0; i--) {
-        Account **accounts = transaction_affected_accounts(bymtime[i]);
-        while (*accounts != NULL) {
-            if (!(*accounts)->inactive) {
-                if (current == count) {
-                    // Didn't allocate enough space. double it.
-                    count *= 2;
-                    res = realloc(res, sizeof(char*) * count);
-                }
-                res[current] = (*accounts)->name;
-                current++;
-            }
-            accounts++;
+transactions_account_names(TransactionList *txns)
+{
+    Account **accounts = (Account **)_mru_list(&txns->accounts);
+    // We reuse `accounts` for our results.
+    char **res = (char **)accounts;
+    char **dst = res;
+    for (Account **iter=accounts; *iter != NULL; iter++) {
+        if (!(*iter)->inactive) {
+            *dst = (*iter)->name;
+            dst++;
         }
     }
-    res[current] = NULL;
+    *dst = NULL;
+    // Two accounts can have the same name.
+    _deduplicate_strings(res);
     return res;
 }
 
+void
+transactions_changed(TransactionList *txns, Transaction *txn)
+{
+    TxnIndex *old = g_hash_table_lookup(txns->members, txn);
+    if (old == NULL) {
+        return;
+    }
+    g_hash_table_steal(txns->members, txn);
+    // Adding new holders before removing old ones spares unchanged values
+    // from leaving our indexes.
+    _transactions_index(txns, txn);
+    _transactions_unindex_holders(txns, old);
+}
+
 void
 transactions_add(TransactionList *txns, Transaction *txn, bool keep_position)
 {
+    _transactions_ensure_sorted(txns);
     if (!keep_position) {
-        Transaction **others = transactions_at_date(txns, txn->date);
-        if (others != NULL) {
-            Transaction **iter = others;
-            while (*iter != NULL) {
-                if ((*iter)->position >= txn->position) {
-                    txn->position = (*iter)->position + 1;
-                }
-                iter++;
+        // The last txn of the date has the highest position.
+        unsigned int index = _transactions_bisect_date(txns, txn->date + 1);
+        if (index > 0) {
+            Transaction *last = txns->txns[index-1];
+            if (last->date == txn->date && last->position >= txn->position) {
+                txn->position = last->position + 1;
             }
-            free(others);
         }
     }
+    if (txns->count == txns->capacity) {
+        unsigned int capacity = txns->capacity * 2;
+        if (capacity < TRANSACTIONS_MIN_CAPACITY) {
+            capacity = TRANSACTIONS_MIN_CAPACITY;
+        }
+        txns->txns = realloc(txns->txns, sizeof(Transaction*) * capacity);
+        txns->capacity = capacity;
+    }
+    unsigned int index = _transactions_bisect(txns, txn, true);
+    memmove(
+        &txns->txns[index+1],
+        &txns->txns[index],
+        sizeof(Transaction*) * (txns->count - index));
+    txns->txns[index] = txn;
     txns->count++;
-    txns->txns = realloc(txns->txns, sizeof(Transaction*) * txns->count);
-    txns->txns[txns->count-1] = txn;
+    _transactions_index(txns, txn);
 }
 
 Transaction**
-transactions_at_date(const TransactionList *txns, time_t date)
-{
-    /* We don't (yet) maintain sort order at all times, so we have to iterate
-     * through the whole list. However, most of the time, all resulting txns
-     * will be bunched up together. Because we don't know how many elements we
-     * need to allocate yet, we start with a first pass, to get first/last
-     * indexes and count. This then allows us to allocate and, with first/last,
-     * make the second pass usually much faster.
-     */
-    int first, last, count=0;
-    for (int i=0; i<txns->count; i++) {
-        if (txns->txns[i]->date == date) {
-            last = i;
-            if (count == 0) {
-                first = i;
-            }
-            count++;
-        }
+transactions_at_date(TransactionList *txns, time_t date)
+{
+    _transactions_ensure_sorted(txns);
+    unsigned int first = _transactions_bisect_date(txns, date);
+    unsigned int last = first;
+    while (last < txns->count && txns->txns[last]->date == date) {
+        last++;
     }
+    int count = last - first;
     if (count == 0) {
         return NULL;
     }
     Transaction** res = malloc(sizeof(Transaction*) * (count+1));
-    int fillindex = 0;
-    for (int i=first; i<=last; i++) {
-        if (txns->txns[i]->date == date) {
-            res[fillindex] = txns->txns[i];
-            fillindex++;
-        }
-    }
+    memcpy(res, &txns->txns[first], sizeof(Transaction*) * count);
     res[count] = NULL;
     return res;
 }
 
 char**
-transactions_descriptions(const TransactionList *txns)
+transactions_descriptions(TransactionList *txns)
 {
-    Transaction **bymtime = malloc(sizeof(Transaction*) * txns->count);
-    memcpy(bymtime, txns->txns, sizeof(Transaction*) * txns->count);
-    qsort(bymtime, txns->count, sizeof(Transaction*), _txn_cmp_mtime);
-
-    char **res = malloc(sizeof(char*) * (txns->count + 1));
-    char **iter = res;
-    for (int i=txns->count-1; i>=0; i--) {
-        *iter = bymtime[i]->description;
-        if (*iter != NULL) {
-            iter++;
-        }
-    }
-    *iter = NULL;
-    return res;
+    return (char **)_mru_list(&txns->descriptions);
 }
 
 int
-transactions_find(const TransactionList *txns, Transaction *txn)
+transactions_find(TransactionList *txns, Transaction *txn)
 {
-    for (int i=0; i<txns->count; i++) {
-        if (txns->txns[i] == txn) {
+    if (!g_hash_table_contains(txns->members, txn)) {
+        return -1;
+    }
+    _transactions_ensure_sorted(txns);
+    // `txn` is among txns with the same sort key.
+    for (unsigned int i=_transactions_bisect(txns, txn, false); i<txns->count; i++) {
+        Transaction *other = txns->txns[i];
+        if (other == txn) {
             return i;
         }
+        if (_txn_cmp(other, txn) != 0) {
+            break;
+        }
     }
     return -1;
 }
 
 void
 transactions_move_before(
-    const TransactionList *txns,
+    TransactionList *txns,
     Transaction *txn,
     Transaction *target)
 {
@@ -198,11 +566,15 @@ transactions_move_before(
     if ((target != NULL) && (txn->date != target->date)) {
         target = NULL;
     }
-    Transaction **bunch = transactions_at_date(txns, txn->date);
+    // Our bunch is a slice of our list. We work on it in place.
+    unsigned int first = _transactions_bisect_date(txns, txn->date);
+    unsigned int count = _transactions_bisect_date(txns, txn->date + 1) - first;
+    Transaction **bunch = &txns->txns[first];
     Transaction **iter = bunch;
+    Transaction **end = &bunch[count];
     if (target == NULL) {
         // set txn->position to the highest value of its bunch
-        while (*iter != NULL) {
+        while (iter < end) {
             if ((*iter != txn) && ((*iter)->position >= txn->position)) {
                 txn->position = (*iter)->position + 1;
             }
@@ -211,33 +583,21 @@ transactions_move_before(
     } else {
         // set txn position to its target and offset everything after it
         txn->position = target->position;
-        while (*iter != NULL) {
+        while (iter < end) {
             if ((*iter != txn) && ((*iter)->position >= txn->position)) {
                 (*iter)->position++;
             }
             iter++;
         }
     }
-    free(bunch);
+    // Positions changed, but only within our bunch.
+    qsort(bunch, count, sizeof(Transaction*), _txn_cmp_key);
 }
 
 char**
-transactions_payees(const TransactionList *txns)
+transactions_payees(TransactionList *txns)
 {
-    Transaction **bymtime = malloc(sizeof(Transaction*) * txns->count);
-    memcpy(bymtime, txns->txns, sizeof(Transaction*) * txns->count);
-    qsort(bymtime, txns->count, sizeof(Transaction*), _txn_cmp_mtime);
-
-    char **res = malloc(sizeof(char*) * (txns->count + 1));
-    char **iter = res;
-    for (int i=txns->count-1; i>=0; i--) {
-        *iter = bymtime[i]->payee;
-        if (*iter != NULL) {
-            iter++;
-        }
-    }
-    *iter = NULL;
-    return res;
+    return (char **)_mru_list(&txns->payees);
 }
 
 void
@@ -246,15 +606,22 @@ transactions_reassign_account(
     const Account *account,
     Account *to)
 {
-    for (int i=txns->count-1; i>=0; i--) {
+    bool removed = false;
+    for (unsigned int i=0; i<txns->count; i++) {
         Transaction *txn = txns->txns[i];
         if (transaction_reassign_account(txn, account, to)) {
             Account **accounts = transaction_affected_accounts(txn);
             if (accounts[0] == NULL) {
-                transactions_remove(txns, txn);
+                _transactions_unindex(txns, txn);
+                removed = true;
+            } else {
+                transactions_changed(txns, txn);
             }
         }
     }
+    if (removed) {
+        _transactions_compact(txns);
+    }
 }
 
 bool
@@ -271,12 +638,28 @@ transactions_remove(TransactionList *txns, Transaction *txn)
         &txns->txns[index+1],
         sizeof(Transaction*) * (txns->count - index - 1));
     txns->count--;
-    txns->txns = realloc(txns->txns, sizeof(Transaction*) * txns->count);
+    _transactions_unindex(txns, txn);
     return true;
 }
 
+int
+transactions_remove_many(TransactionList *txns, Transaction **toremove)
+{
+    int count = 0;
+    while (*toremove != NULL) {
+        if (_transactions_unindex(txns, *toremove)) {
+            count++;
+        }
+        toremove++;
+    }
+    if (count) {
+        _transactions_compact(txns);
+    }
+    return count;
+}
+
 void
 transactions_sort(TransactionList *txns)
 {
-    qsort(txns->txns, txns->count, sizeof(Transaction*), _txn_cmp_key);
+    _transactions_ensure_sorted(txns);
 }
@@ -1,19 +1,94 @@
 #pragma once
+#include <glib.h>
 #include "transaction.h"
+#include "completion.h"
 
+/* Where a value stands in a MRUIndex. Higher is more recent. */
+typedef struct {
+    time_t mtime;
+    // Among equal mtimes, the value indexed last is the most recent.
+    unsigned int seq;
+} MRUKey;
+
+/* A deduplicated "most recently used" list of values held by txns.
+ *
+ * We remember every holder of every value, sorted by key, so that a value can
+ * fall back to its next most recent holder when one goes away. Adding or
+ * removing a holder is O(log n) and the list itself is always ready.
+ */
+typedef struct {
+    // If true, values are stripped strings, compared by content, and we own
+    // copies of them. Otherwise, they're pointers we don't own.
+    bool strings;
+    // value -> MRUValue*
+    GHashTable *values;
+    // MRUHolder*, sorted by value, then key.
+    GSequence *holders;
+    // MRUValue*, most recent first.
+    GSequence *order;
+    // Incremented whenever `order` changes.
+    unsigned int version;
+    // Only for strings: our values as completion candidates, most recent
+    // first.
+    CompletionIndex completion;
+} MRUIndex;
+
+/* A list of transactions, kept sorted by (date, position).
+ *
+ * We also index the descriptions, payees and accounts of our transactions in
+ * MRU indexes, which give us our "most recently used" lists.
+ *
+ * Changes to the date or position of a transaction that is in a list happen
+ * outside of the list's control. Whoever makes such a change has to call
+ * `transactions_order_changed()` afterwards. Lists then check, the next time
+ * they need their order, whether they have to re-sort.
+ *
+ * Changes to the description, payee, accounts or mtime of a transaction that is
+ * in a list have to be followed by a call to `transactions_changed()`.
+ */
 typedef struct {
     unsigned int count;
+    // Allocated size of `txns`. Grows geometrically.
+    unsigned int capacity;
     Transaction **txns;
+    // Value of the global order generation when we were last known to be
+    // sorted.
+    unsigned int generation;
+    // Maps all Transaction pointers in `txns` to what we indexed of them.
+    GHashTable *members;
+    MRUIndex descriptions;
+    MRUIndex payees;
+    // Holds Account pointers.
+    MRUIndex accounts;
+    // Source of MRUKey.seq
+    unsigned int seq;
 } TransactionList;
 
+/* Notify all lists that a transaction's date or position might have changed.
+ */
+void
+transactions_order_changed(void);
+
 void
 transactions_init(TransactionList *txns);
 
 void
 transactions_deinit(TransactionList *txns);
 
+/* Returns a NULL-terminated list of the names of all active accounts affected
+ * by our txns, most recently modified first and without duplicates.
+ *
+ * The resulting list must be freed with free().
+ */
 char**
-transactions_account_names(const TransactionList *txns);
+transactions_account_names(TransactionList *txns);
+
+/* Re-indexes `txn` after its description, payee, accounts or mtime changed.
+ *
+ * Our MRU lists are updated in place. Does nothing if `txn` isn't ours.
+ */
+void
+transactions_changed(TransactionList *txns, Transaction *txn);
 
 /* keep_position: if true, `txn`'s `position` stays unchanged. if false, we
  *                set `position` so that `txn` ends up at the end of the txns
@@ -28,13 +103,19 @@ transactions_add(TransactionList *txns, Transaction *txn, bool keep_position);
  * matching txn.
  */
 Transaction**
-transactions_at_date(const TransactionList *txns, time_t date);
+transactions_at_date(TransactionList *txns, time_t date);
 
+/* Returns a NULL-terminated list of our txns' descriptions, stripped, most
+ * recently modified first and without duplicates or empty strings.
+ *
+ * Strings in the list belong to `txns` and are valid until its next
+ * modification. The list itself must be freed with free().
+ */
 char**
-transactions_descriptions(const TransactionList *txns);
+transactions_descriptions(TransactionList *txns);
 
 int
-transactions_find(const TransactionList *txns, Transaction *txn);
+transactions_find(TransactionList *txns, Transaction *txn);
 
 /* Move `txn` just before `target`, position-wise.
  *
@@ -49,12 +130,13 @@ transactions_find(const TransactionList *txns, Transaction *txn);
  */
 void
 transactions_move_before(
-    const TransactionList *txns,
+    TransactionList *txns,
     Transaction *txn,
     Transaction *target);
 
+// Same as transactions_descriptions(), but for payees.
 char**
-transactions_payees(const TransactionList *txns);
+transactions_payees(TransactionList *txns);
 
 /* Calls `transaction_reassign_account()` on all transactions.
  *
@@ -70,5 +152,20 @@ transactions_reassign_account(
 bool
 transactions_remove(TransactionList *txns, Transaction *txn);
 
+/* Removes all txns of the NULL-terminated `toremove` list from `txns`.
+ *
+ * Txns that aren't in `txns` are ignored. Our list is compacted in one pass,
+ * which makes this much faster than removing txns one by one.
+ *
+ * Returns the number of removed txns.
+ */
+int
+transactions_remove_many(TransactionList *txns, Transaction **toremove);
+
+/* Makes sure that `txns` is sorted.
+ *
+ * The list maintains its order by itself, so this only does something after
+ * `transactions_order_changed()` has been called.
+ */
 void
 transactions_sort(TransactionList *txns);
@@ -36,7 +36,7 @@ _readd_accounts(Account **accounts, AccountList *alist)
 }
 
 static bool
-_swap_accounts(ChangedAccount *accounts, int count)
+_swap_accounts(ChangedAccount *accounts, int count, AccountList *alist)
 {
     for (int i=0; i<count; i++) {
         ChangedAccount *c = &accounts[i];
@@ -44,12 +44,17 @@ _swap_accounts(ChangedAccount *accounts, int count)
         if (c->account == NULL) {
             return false;
         }
+        accounts_unindex(alist, c->account);
         // We don't use account_copy() because we don't have to mess with
         // string ownership: these ownerships follow cleanly with a simple
         // memcpy().
         memcpy(&tmp, c->account, sizeof(Account));
         memcpy(c->account, &c->copy, sizeof(Account));
         memcpy(&c->copy, &tmp, sizeof(Account));
+        // Our id and list, however, stay the same.
+        c->account->id = tmp.id;
+        c->account->list = tmp.list;
+        accounts_reindex(alist, c->account);
     }
     return true;
 }
@@ -62,11 +67,13 @@ _add_auto_created_accounts(Transaction *txn, AccountList *alist)
         if (split->account == NULL) {
             continue;
         }
-        // TODO: replace this by some kind of undelete: pretty much certain to
-        // be in alist's trash can.
         if (accounts_find_by_name(alist, split->account->name) == NULL) {
-            Account *a = accounts_create(alist);
-            account_copy(a, split->account);
+            // Pretty much certain to be in alist's trash can. Undeleting it
+            // brings back the account our split points to, entries included.
+            if (!accounts_undelete(alist, split->account)) {
+                Account *a = accounts_create(alist);
+                account_copy(a, split->account);
+            }
         }
     }
 }
@@ -80,7 +87,7 @@ _remove_auto_created_account(Transaction *txn, AccountList *alist)
             continue;
         }
         EntryList *el = accounts_entries_for_account(alist, split->account);
-        if (el->count <= 1) {
+        if (el != NULL && el->count <= 1) {
             Account *a = accounts_find_by_name(alist, split->account->name);
             if (a != NULL) {
                 accounts_remove(alist, a);
@@ -130,23 +137,193 @@ _readd_txns(Transaction **txns, TransactionList *tlist, AccountList *alist)
     return true;
 }
 
+static void
+_swap_str(char **a, char **b)
+{
+    char *tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static void
+_swap_time(time_t *a, time_t *b)
+{
+    time_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+// Swaps the `fields` of `txn` and `copy`.
+static void
+_swap_txn_fields(Transaction *txn, Transaction *copy, TransactionField fields)
+{
+    // We don't use transaction_copy() because we don't have to mess with
+    // string or split ownership: these ownerships follow cleanly with simple
+    // swaps.
+    if (fields & TXN_FIELD_TYPE) {
+        TransactionType tmp = txn->type;
+        txn->type = copy->type;
+        copy->type = tmp;
+    }
+    if (fields & TXN_FIELD_DATE) {
+        _swap_time(&txn->date, &copy->date);
+    }
+    if (fields & TXN_FIELD_DESCRIPTION) {
+        _swap_str(&txn->description, &copy->description);
+    }
+    if (fields & TXN_FIELD_PAYEE) {
+        _swap_str(&txn->payee, &copy->payee);
+    }
+    if (fields & TXN_FIELD_CHECKNO) {
+        _swap_str(&txn->checkno, &copy->checkno);
+    }
+    if (fields & TXN_FIELD_NOTES) {
+        _swap_str(&txn->notes, &copy->notes);
+    }
+    if (fields & TXN_FIELD_POSITION) {
+        int tmp = txn->position;
+        txn->position = copy->position;
+        copy->position = tmp;
+    }
+    if (fields & TXN_FIELD_MTIME) {
+        _swap_time(&txn->mtime, &copy->mtime);
+    }
+    if (fields & TXN_FIELD_SPLITS) {
+        Split *splits = txn->splits;
+        txn->splits = copy->splits;
+        copy->splits = splits;
+        unsigned int *splitsref = txn->splitsref;
+        txn->splitsref = copy->splitsref;
+        copy->splitsref = splitsref;
+        unsigned int splitcount = txn->splitcount;
+        txn->splitcount = copy->splitcount;
+        copy->splitcount = splitcount;
+    }
+}
+
+static bool
+_streq(const char *a, const char *b)
+{
+    if (a == NULL || b == NULL) {
+        return a == b;
+    }
+    return strcmp(a, b) == 0;
+}
+
+// Allocated size of a string set with strset() or strclone().
+static size_t
+_strsize(const char *s)
+{
+    if (s == NULL || s[0] == '\0') {
+        return 0;
+    }
+    return strlen(s) + 1;
+}
+
+// Allocated size of a NULL-terminated list. Empty lists aren't allocated.
+static size_t
+_listsize(void **list)
+{
+    if (list == NULL) {
+        return 0;
+    }
+    return sizeof(void*) * (listlen(list) + 1);
+}
+
+static bool
+_splits_eq(const Transaction *a, const Transaction *b)
+{
+    if (a->splitcount != b->splitcount) {
+        return false;
+    }
+    for (unsigned int i=0; i<a->splitcount; i++) {
+        const Split *s1 = &a->splits[i];
+        const Split *s2 = &b->splits[i];
+        if (s1->account != s2->account
+                || s1->amount.val != s2->amount.val
+                || s1->amount.currency != s2->amount.currency
+                || s1->reconciliation_date != s2->reconciliation_date
+                || s1->index != s2->index
+                || !_streq(s1->memo, s2->memo)
+                || !_streq(s1->reference, s2->reference)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Drops the fields of `c->copy` that are the same as in `c->txn`.
+static void
+_compact_txn(ChangedTransaction *c)
+{
+    Transaction *txn = c->txn;
+    Transaction *copy = &c->copy;
+    if (copy->type == txn->type) {
+        c->fields &= ~TXN_FIELD_TYPE;
+    }
+    if (copy->date == txn->date) {
+        c->fields &= ~TXN_FIELD_DATE;
+    }
+    if (_streq(copy->description, txn->description)) {
+        strfree(&copy->description);
+        copy->description = NULL;
+        c->fields &= ~TXN_FIELD_DESCRIPTION;
+    }
+    if (_streq(copy->payee, txn->payee)) {
+        strfree(&copy->payee);
+        copy->payee = NULL;
+        c->fields &= ~TXN_FIELD_PAYEE;
+    }
+    if (_streq(copy->checkno, txn->checkno)) {
+        strfree(&copy->checkno);
+        copy->checkno = NULL;
+        c->fields &= ~TXN_FIELD_CHECKNO;
+    }
+    if (_streq(copy->notes, txn->notes)) {
+        strfree(&copy->notes);
+        copy->notes = NULL;
+        c->fields &= ~TXN_FIELD_NOTES;
+    }
+    if (copy->position == txn->position) {
+        c->fields &= ~TXN_FIELD_POSITION;
+    }
+    if (copy->mtime == txn->mtime) {
+        c->fields &= ~TXN_FIELD_MTIME;
+    }
+    if (_splits_eq(copy, txn)) {
+        for (unsigned int i=0; i<copy->splitcount; i++) {
+            split_deinit(&copy->splits[i]);
+        }
+        free(copy->splits);
+        copy->splits = NULL;
+        copy->splitcount = 0;
+        c->fields &= ~TXN_FIELD_SPLITS;
+    }
+}
+
 static bool
-_swap_txns(ChangedTransaction *txns, int count, AccountList *alist)
+_swap_txns(
+    ChangedTransaction *txns,
+    int count,
+    TransactionList *tlist,
+    AccountList *alist)
 {
     for (int i=0; i<count; i++) {
         ChangedTransaction *c = &txns[i];
-        Transaction tmp;
         if (c->txn == NULL) {
             return false;
         }
-        _remove_auto_created_account(c->txn, alist);
-        // We don't use transaction_copy() because we don't have to mess with
-        // string or split ownership: these ownerships follow cleanly with a
-        // simple memcpy().
-        memcpy(&tmp, c->txn, sizeof(Transaction));
-        memcpy(c->txn, &c->copy, sizeof(Transaction));
-        memcpy(&c->copy, &tmp, sizeof(Transaction));
-        _add_auto_created_accounts(c->txn, alist);
+        if (c->fields & TXN_FIELD_SPLITS) {
+            _remove_auto_created_account(c->txn, alist);
+        }
+        _swap_txn_fields(c->txn, &c->copy, c->fields);
+        if (c->fields & TXN_FIELD_SPLITS) {
+            _add_auto_created_accounts(c->txn, alist);
+        }
+        transactions_changed(tlist, c->txn);
+    }
+    if (count) {
+        transactions_order_changed();
     }
     return true;
 }
@@ -205,7 +382,9 @@ undostep_init(
         ChangedTransaction *c = &step->changed_txns[i];
         c->txn = changed_txns[i];
         transaction_copy(&c->copy, c->txn);
+        c->fields = TXN_FIELD_ALL;
     }
+    step->compacted = false;
 }
 
 void
@@ -229,16 +408,64 @@ undostep_deinit(UndoStep *step)
     step->changed_txns = NULL;
 }
 
+void
+undostep_compact(UndoStep *step)
+{
+    if (step->compacted) {
+        return;
+    }
+    for (int i=0; i<step->changed_txns_count; i++) {
+        _compact_txn(&step->changed_txns[i]);
+    }
+    step->compacted = true;
+}
+
+size_t
+undostep_footprint(const UndoStep *step)
+{
+    size_t res = sizeof(UndoStep);
+    res += _listsize((void *)step->added_accounts);
+    res += _listsize((void *)step->deleted_accounts);
+    res += _listsize((void *)step->added_txns);
+    res += _listsize((void *)step->deleted_txns);
+    for (int i=0; i<step->changed_account_count; i++) {
+        const Account *a = &step->changed_accounts[i].copy;
+        res += sizeof(ChangedAccount);
+        res += _strsize(a->name);
+        res += _strsize(a->name_key);
+        res += _strsize(a->reference);
+        res += _strsize(a->groupname);
+        res += _strsize(a->account_number);
+        res += _strsize(a->notes);
+    }
+    for (int i=0; i<step->changed_txns_count; i++) {
+        const Transaction *t = &step->changed_txns[i].copy;
+        res += sizeof(ChangedTransaction);
+        res += _strsize(t->description);
+        res += _strsize(t->payee);
+        res += _strsize(t->checkno);
+        res += _strsize(t->notes);
+        res += sizeof(Split) * t->splitcount;
+        for (unsigned int j=0; j<t->splitcount; j++) {
+            res += _strsize(t->splits[j].memo);
+            res += _strsize(t->splits[j].reference);
+        }
+    }
+    return res;
+}
+
 bool
 undostep_undo(UndoStep *step, AccountList *alist, TransactionList *tlist)
 {
+    undostep_compact(step);
     if (!_remove_accounts(step->added_accounts, alist)) {
         return false;
     }
     if (!_readd_accounts(step->deleted_accounts, alist)) {
         return false;
     }
-    if (!_swap_accounts(step->changed_accounts, step->changed_account_count)) {
+    if (!_swap_accounts(
+            step->changed_accounts, step->changed_account_count, alist)) {
         return false;
     }
     if (!_remove_txns(step->added_txns, tlist, alist)) {
@@ -247,7 +474,8 @@ undostep_undo(UndoStep *step, AccountList *alist, TransactionList *tlist)
     if (!_readd_txns(step->deleted_txns, tlist, alist)) {
         return false;
     }
-    if (!_swap_txns(step->changed_txns, step->changed_txns_count, alist)) {
+    if (!_swap_txns(
+            step->changed_txns, step->changed_txns_count, tlist, alist)) {
         return false;
     }
     return true;
@@ -262,7 +490,8 @@ undostep_redo(UndoStep *step, AccountList *alist, TransactionList *tlist)
     if (!_remove_accounts(step->deleted_accounts, alist)) {
         return false;
     }
-    if (!_swap_accounts(step->changed_accounts, step->changed_account_count)) {
+    if (!_swap_accounts(
+            step->changed_accounts, step->changed_account_count, alist)) {
         return false;
     }
     if (!_readd_txns(step->added_txns, tlist, alist)) {
@@ -271,7 +500,8 @@ undostep_redo(UndoStep *step, AccountList *alist, TransactionList *tlist)
     if (!_remove_txns(step->deleted_txns, tlist, alist)) {
         return false;
     }
-    if (!_swap_txns(step->changed_txns, step->changed_txns_count, alist)) {
+    if (!_swap_txns(
+            step->changed_txns, step->changed_txns_count, tlist, alist)) {
         return false;
     }
     return true;
@@ -7,9 +7,26 @@ typedef struct {
     Account copy;
 } ChangedAccount;
 
+// Transaction fields that a ChangedTransaction can hold.
+typedef enum {
+    TXN_FIELD_TYPE = 1 << 0,
+    TXN_FIELD_DATE = 1 << 1,
+    TXN_FIELD_DESCRIPTION = 1 << 2,
+    TXN_FIELD_PAYEE = 1 << 3,
+    TXN_FIELD_CHECKNO = 1 << 4,
+    TXN_FIELD_NOTES = 1 << 5,
+    TXN_FIELD_POSITION = 1 << 6,
+    TXN_FIELD_MTIME = 1 << 7,
+    TXN_FIELD_SPLITS = 1 << 8,
+    TXN_FIELD_ALL = (1 << 9) - 1,
+} TransactionField;
+
 typedef struct {
     Transaction *txn;
+    // Only the fields in `fields` are held (and owned) by `copy`. Others are
+    // zeroed.
     Transaction copy;
+    TransactionField fields;
 } ChangedTransaction;
 
 /* References to added and deleted entities are direct references. The
@@ -19,7 +36,9 @@ typedef struct {
  *
  * References to changed entities, however, are copies. To be able to remember
  * changed values, we need to copy those entities. Those copies are owned by
- * the UndoStep.
+ * the UndoStep. Because we're created before the change happens, we start
+ * with full transaction copies. Once the change is made, undostep_compact()
+ * trims them down to the fields that changed.
  * 
  * MEMORY MANAGEMENT: memory model of the UndoStep is sound as long as it is
  * used sanely, that is, in the proper order. Don't undo or redo twice in a
@@ -35,6 +54,7 @@ typedef struct {
     Transaction **deleted_txns;
     ChangedTransaction *changed_txns;
     int changed_txns_count;
+    bool compacted;
 } UndoStep;
 
 /* This function takes care of make appropriate copies. You should send it
@@ -53,6 +73,24 @@ undostep_init(
 void
 undostep_deinit(UndoStep *step);
 
+/* Drops the transaction fields that are the same in our copies and in the
+ * live transactions.
+ *
+ * Call it after the recorded change has been made. Our copies then hold the
+ * "before" values and swapping only the fields that differ is enough to undo
+ * and redo. It's also fine to call it after an undo. Only the first call does
+ * something. undostep_undo() calls it.
+ */
+void
+undostep_compact(UndoStep *step);
+
+/* Returns the number of bytes that `step` holds, not counting entities it
+ * references directly (added and deleted ones), which are owned by their
+ * lists.
+ */
+size_t
+undostep_footprint(const UndoStep *step);
+
 /* Returns whether undo could be completed successfully.
  */
 bool
@@ -91,6 +91,24 @@ strstrip(char **dst, const char *src)
     return true;
 }
 
+char*
+strstripped(const char *src)
+{
+    if (src == NULL || src[0] == '\0') {
+        return NULL;
+    }
+    char *res = NULL;
+    if (!strstrip(&res, src)) {
+        strclone(&res, src);
+    }
+    // Whether it comes from strstrip() or strclone(), `res` is malloc'ed.
+    if (res[0] == '\0') {
+        free(res);
+        return NULL;
+    }
+    return res;
+}
+
 /* Time */
 
 static time_t g_patched_today = 0;
@@ -113,6 +131,35 @@ today_patch(time_t today)
     g_patched_today = today;
 }
 
+/* Both conversions work with 400 years "eras" starting on March 1st, which
+ * puts leap days at the end of their year. See
+ * http://howardhinnant.github.io/date_algorithms.html
+ */
+int
+days_from_civil(int year, int month, int day)
+{
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yoe = year - era * 400;
+    int doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+void
+civil_from_days(int days, int *year, int *month, int *day)
+{
+    days += 719468;
+    int era = (days >= 0 ? days : days - 146096) / 146097;
+    int doe = days - era * 146097;
+    int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int mp = (5 * doy + 2) / 153;
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = yoe + era * 400 + (*month <= 2);
+}
+
 static time_t g_prevnow = 0;
 
 time_t
@@ -50,6 +50,13 @@ strclone(char **dst, const char *src);
 bool
 strstrip(char **dst, const char *src);
 
+/* Returns a malloc'ed copy of `src` with stripped leading and trailing spaces.
+ *
+ * Returns NULL, and mallocs nothing, if `src` is NULL or blank.
+ */
+char*
+strstripped(const char *src);
+
 /* Time */
 // Returns today's time_t in a "normalized" way (truncated to discard time).
 // today() == today() if both are called in the same day.
@@ -60,6 +67,16 @@ today();
 void
 today_patch(time_t today);
 
+// Returns the number of days between 1970-01-01 and the date `year`-`month`-
+// `day` of the proleptic Gregorian calendar (`month` and `day` start at 1).
+// Pure integer arithmetic: no timezone or global state involved.
+int
+days_from_civil(int year, int month, int day);
+
+// Inverse of days_from_civil().
+void
+civil_from_days(int days, int *year, int *month, int *day);
+
 // Returns time(0) but at the same time ensures uniqueness of the results. If
 // In other words, now() < now() is always true. This causes us to bend time
 // a little bit when needed.
@@ -23,11 +23,13 @@ class PreferenceNames:
     * ``AutoDecimalPlace``
     * ``CustomRanges``
     * ``ShowScheduleScopeDialog``
+    * ``UndoMemoryLimit``
     """
     AutoSaveInterval = 'AutoSaveInterval'
     AutoDecimalPlace = 'AutoDecimalPlace'
     DayFirstDateEntry = 'DayFirstDateEntry'
     ShowScheduleScopeDialog = 'ShowScheduleScopeDialog'
+    UndoMemoryLimit = 'UndoMemoryLimit'
 
 class ApplicationView:
     """Expected interface for :class:`Application`'s view.
@@ -111,6 +113,7 @@ class Application:
         self._auto_decimal_place = self.get_default(PreferenceNames.AutoDecimalPlace, False)
         self._day_first_date_entry = self.get_default(PreferenceNames.DayFirstDateEntry, True)
         self._show_schedule_scope_dialog = self.get_default(PreferenceNames.ShowScheduleScopeDialog, True)
+        self._undo_memory_limit = self.get_default(PreferenceNames.UndoMemoryLimit, 0)
         self._hook_currency_providers()
         self._update_date_entry_order()
 
@@ -233,3 +236,19 @@ class Application:
         self._show_schedule_scope_dialog = value
         self.set_default(PreferenceNames.ShowScheduleScopeDialog, value)
 
+    @property
+    def undo_memory_limit(self):
+        """*get/set int*. Memory (in MB) that a document's undo history can use. 0 means no limit.
+
+        When the limit is reached, the oldest actions can't be undone anymore. With a limit,
+        consecutive changes to the same transactions are also merged in a single action to save
+        room, so they're undone together. Takes effect on newly created documents.
+        """
+        return self._undo_memory_limit
+
+    @undo_memory_limit.setter
+    def undo_memory_limit(self, value):
+        if value == self._undo_memory_limit:
+            return
+        self._undo_memory_limit = value
+        self.set_default(PreferenceNames.UndoMemoryLimit, value)
@@ -19,6 +19,7 @@ from .const import NOEDIT, AccountType
 from .exception import FileFormatError, OperationAborted
 from .gui.base import GUIObject
 from .loader import native
+from .loader.journal import read_records, replay, snapshot_path
 from .model._ccore import (
     AccountList, Entry, TransactionList, amount_parse, amount_format)
 from .model.currency import Currencies
@@ -27,6 +28,7 @@ from .model.date import YearRange
 from .model.oven import Oven
 from .model.undo import Undoer, Action
 from .model.recurrence import find_schedule_of_ref
+from .saver.journal import Journal, JOURNAL_SUFFIX
 from .saver.native import save as save_native
 
 EXCLUDED_ACCOUNTS_PREFERENCE = 'ExcludedAccounts'
@@ -90,7 +92,16 @@ class Document(GUIObject):
         self.excluded_accounts = set()
         # Keep track of newly added groups between refreshes
         self.newgroups = set()
-        self._undoer = Undoer(self.accounts, self.transactions, self.schedules, self.budgets)
+        # Under a memory limit, we merge consecutive changes to the same transactions to save
+        # room. See Application.undo_memory_limit.
+        self._undoer = Undoer(
+            self.accounts, self.transactions, self.schedules, self.budgets,
+            memory_limit=self.app.undo_memory_limit * 1024 * 1024,
+            merge_changes=self.app.undo_memory_limit > 0,
+        )
+        self._undoer.on_action = self._note_action
+        # Journal of the changes made since our file was last saved. None until we have a file.
+        self._journal = None
         self._date_range = YearRange(datetime.date.today())
         self._document_id = None
         self._dirty_flag = False
@@ -102,9 +113,13 @@ class Document(GUIObject):
         for txn in transactions:
             self.transactions.add(txn)
         min_date = min(t.date for t in transactions)
-        self._cook(from_date=min_date)
+        self._cook(from_date=min_date, dirty_accounts=self._affected_accounts(transactions))
 
     def _autosave(self):
+        if self._journal is not None:
+            # Our file is only written on explicit saves. What we save until then are our changes.
+            self._journal.flush(self.accounts, self.transactions, self._properties, self._write_xml)
+            return
         existing_names = [name for name in os.listdir(self.app.cache_path) if name.startswith('autosave')]
         existing_names.sort()
         timestamp = int(time.time())
@@ -116,6 +131,13 @@ class Document(GUIObject):
         if len(existing_names) >= AUTOSAVE_BUFFER_COUNT:
             os.remove(op.join(self.app.cache_path, existing_names[0]))
 
+    @staticmethod
+    def _affected_accounts(transactions):
+        result = set()
+        for txn in transactions:
+            result |= txn.affected_accounts()
+        return result
+
     def _change_transaction(self, transaction, global_scope=False, **kwargs):
         date = kwargs.get('date', NOEDIT)
         date_changed = date is not NOEDIT and date != transaction.date
@@ -135,13 +157,20 @@ class Document(GUIObject):
                 self.transactions.add(transaction)
             elif date_changed:
                 self.transactions.move_last(transaction)
-        self.transactions.clear_cache()
+        self.transactions.changed(transaction)
 
-    def _cook(self, from_date=None):
-        self.oven.cook(from_date=from_date, until_date=self.date_range.end)
+    def _cook(self, from_date=None, dirty_accounts=None):
+        self.oven.cook(
+            from_date=from_date, until_date=self.date_range.end, dirty_accounts=dirty_accounts
+        )
         # Whenever we cook, we touch. That saves us some touch() repetitions.
         self.touch()
 
+    def _discard_journal(self):
+        if self._journal is not None:
+            self._journal.discard()
+            self._journal = None
+
     def _get_action_from_changed_transactions(self, transactions, global_scope=False):
         if len(transactions) == 1 and not transactions[0].is_spawn \
                 and transactions[0] not in self.transactions:
@@ -155,6 +184,10 @@ class Document(GUIObject):
             action.change_transactions(spawns, self.schedules)
         return action
 
+    def _note_action(self, action):
+        if self._journal is not None:
+            self._journal.note(action)
+
     def _query_for_scope_if_needed(self, transactions):
         """Queries the UI for change scope if there's any Spawn among transactions.
 
@@ -191,6 +224,30 @@ class Document(GUIObject):
         excluded_account_names = [a.name for a in self.excluded_accounts]
         self.set_default(EXCLUDED_ACCOUNTS_PREFERENCE, excluded_account_names)
 
+    def _update_balances(self, transaction):
+        accounts = {split.account for split in transaction.splits if split.account is not None}
+        for account in accounts:
+            if not self.accounts.entries_for_account(account).transaction_changed(transaction):
+                return False
+        return True
+
+    def _update_reconciled_balances(self, entries):
+        for entry in entries:
+            if entry.account is None:
+                return False
+            entrylist = self.accounts.entries_for_account(entry.account)
+            if not entrylist.reconciliation_changed(entry):
+                return False
+        return True
+
+    def _write_xml(self, filename):
+        if self._document_id is None:
+            self._document_id = uuid.uuid4().hex
+        save_native(
+            filename, self._document_id, self._properties, self.accounts,
+            self.transactions, self.schedules, self.budgets
+        )
+
     # --- Account
     def change_accounts(
             self, accounts, name=NOEDIT, type=NOEDIT, currency=NOEDIT,
@@ -241,7 +298,6 @@ class Document(GUIObject):
             if kwargs:
                 account.change(**kwargs)
         self._cook()
-        self.transactions.clear_cache()
         return True
 
     def delete_accounts(self, accounts, reassign_to=None):
@@ -360,6 +416,7 @@ class Document(GUIObject):
         action = Action(tr('Change transaction'))
         action.change_transactions([original], self.schedules)
         self._undoer.record(action)
+        dirty_accounts = original.affected_accounts()
         # don't forget that account up here is an external instance. Even if an account of
         # the same name exists in self.accounts, it's not gonna be the same instance.
         for split in new.splits:
@@ -371,7 +428,8 @@ class Document(GUIObject):
             original, date=new.date, description=new.description,
             payee=new.payee, checkno=new.checkno, notes=new.notes, global_scope=global_scope
         )
-        self._cook(from_date=min_date)
+        dirty_accounts |= original.affected_accounts()
+        self._cook(from_date=min_date, dirty_accounts=dirty_accounts)
         self.accounts.clean_empty_categories()
         self.date_range = self.date_range.around(original.date)
 
@@ -407,13 +465,15 @@ class Document(GUIObject):
             Currencies.get_rates_db().ensure_rates(date, currencies_to_ensure)
 
         min_date = date if date is not NOEDIT else datetime.date.max
+        dirty_accounts = self._affected_accounts(transactions)
         for transaction in transactions:
             min_date = min(min_date, transaction.date)
             self._change_transaction(
                 transaction, date=date, description=description, payee=payee, checkno=checkno,
                 from_=from_, to=to, amount=amount, currency=currency, global_scope=global_scope
             )
-        self._cook(from_date=min_date)
+        dirty_accounts |= self._affected_accounts(transactions)
+        self._cook(from_date=min_date, dirty_accounts=dirty_accounts)
         self.accounts.clean_empty_categories()
         self.date_range = self.date_range.around(transactions[-1].date)
 
@@ -432,18 +492,16 @@ class Document(GUIObject):
         action.change_transactions(spawns, self.schedules)
         action.deleted_transactions |= set(txns)
         self._undoer.record(action)
-        for txn in transactions:
-            if txn.is_spawn:
-                schedule = find_schedule_of_ref(txn.ref, self.schedules)
-                assert schedule is not None
-                if global_scope:
-                    schedule.stop_before(txn)
-                else:
-                    schedule.delete(txn)
+        for txn in spawns:
+            schedule = find_schedule_of_ref(txn.ref, self.schedules)
+            assert schedule is not None
+            if global_scope:
+                schedule.stop_before(txn)
             else:
-                self.transactions.remove(txn)
+                schedule.delete(txn)
+        self.transactions.remove_many(txns)
         min_date = min(t.date for t in transactions)
-        self._cook(from_date=min_date)
+        self._cook(from_date=min_date, dirty_accounts=self._affected_accounts(transactions))
         self.accounts.clean_empty_categories(from_account)
 
     def duplicate_transactions(self, transactions):
@@ -523,6 +581,15 @@ class Document(GUIObject):
             entry = Entry(newsplit, newtxn)
             action.added_transactions.add(newtxn)
         self._undoer.record(action)
+        # When only the amount changes, balances can be updated in place rather than re-cooked.
+        # Budget spawns depend on amounts, so we can't do that when we have budgets.
+        amount_only = all(
+            value is NOEDIT
+            for value in [date, reconciliation_date, description, payee, checkno, transfer]
+        )
+        in_place = amount_only and not global_scope and not self.budgets \
+            and not entry.transaction.is_spawn and entry.transaction in self.transactions
+        dirty_accounts = entry.transaction.affected_accounts()
         candidate_dates = [entry.date, date, reconciliation_date, entry.reconciliation_date]
         min_date = min(d for d in candidate_dates if d is not NOEDIT and d is not None)
         if reconciliation_date is not NOEDIT:
@@ -537,7 +604,11 @@ class Document(GUIObject):
             entry.transaction, date=date, description=description,
             payee=payee, checkno=checkno, global_scope=global_scope
         )
-        self._cook(from_date=min_date)
+        if in_place and self._update_balances(entry.transaction):
+            self.touch()
+        else:
+            dirty_accounts |= entry.transaction.affected_accounts()
+            self._cook(from_date=min_date, dirty_accounts=dirty_accounts)
         self.accounts.clean_empty_categories()
         self.date_range = self.date_range.around(entry.date)
 
@@ -582,7 +653,13 @@ class Document(GUIObject):
         else:
             for entry in entries:
                 entry.split.reconciliation_date = None
-        self._cook(from_date=min_date)
+        # Toggling doesn't move entries in reconciliation order, so we can
+        # usually update reconciled balances in place rather than re-cooking.
+        if spawns or not self._update_reconciled_balances(entries):
+            txns = {e.transaction for e in entries}
+            self._cook(from_date=min_date, dirty_accounts=self._affected_accounts(txns))
+        else:
+            self.touch()
 
     # --- Budget
     def budgeted_amount(self, date_range, filter_excluded=True):
@@ -703,11 +780,24 @@ class Document(GUIObject):
 
         ``filename`` must be a path to a moneyGuru XML document.
 
+        If there's a journal next to it, we crashed before saving changes made to it and we replay
+        them. The document is then considered modified.
+
         :param filename: ``str``
         """
+        journal_path = filename + JOURNAL_SUFFIX
+        if self._journal is not None and self._journal.path == journal_path:
+            # We're reloading our own file. Our changes are being discarded.
+            records = []
+        else:
+            records = read_records(journal_path)
+        snapshot = snapshot_path(journal_path, records)
+        if snapshot is not None and not op.exists(snapshot):
+            snapshot = None
+            records = []
         loader = native.Loader(self.default_currency)
         try:
-            loader.parse(filename)
+            loader.parse(snapshot or filename)
         except FileFormatError:
             raise FileFormatError(tr('"%s" is not a moneyGuru file') % filename)
         loader.load()
@@ -728,9 +818,15 @@ class Document(GUIObject):
         self.budgets.repeat_every = loader.budgets.repeat_every
         for budget in loader.budgets:
             self.budgets.append(budget)
+        self._journal = Journal(journal_path)
+        self._journal.reset(self.accounts, self.transactions, self._properties)
+        if records:
+            replay(records, self._journal, self.accounts, self.transactions, self._properties)
+            self._journal.resume(op.basename(snapshot) if snapshot else None, self._properties)
         self.accounts.default_currency = self.default_currency
         self._cook()
         self._undoer.set_save_point()
+        self._dirty_flag = bool(records)
         self._restore_preferences_after_load()
 
     def save_to_xml(self, filename, autosave=False):
@@ -739,20 +835,19 @@ class Document(GUIObject):
         ``filename`` must be a path to a moneyGuru XML document.
 
         If ``autosave`` is true, the operation will not affect the document's
-        modified state.
+        modified state. Otherwise, our changes are now in ``filename`` and we start a new journal
+        next to it.
 
         :param filename: ``str``
         :param autosave: ``bool``
         """
-        if self._document_id is None:
-            self._document_id = uuid.uuid4().hex
-        save_native(
-            filename, self._document_id, self._properties, self.accounts,
-            self.transactions, self.schedules, self.budgets
-        )
+        self._write_xml(filename)
         if not autosave:
             self._undoer.set_save_point()
             self._dirty_flag = False
+            self._discard_journal()
+            self._journal = Journal(filename + JOURNAL_SUFFIX)
+            self._journal.reset(self.accounts, self.transactions, self._properties)
 
     def import_entries(self, target_account, ref_account, matches):
         """Imports entries in ``mathes`` into ``target_account``.
@@ -889,8 +984,13 @@ class Document(GUIObject):
         self._undoer.redo()
         self._cook()
 
+    def undo_memory_usage(self):
+        """Returns the number of bytes held by our undo history."""
+        return self._undoer.memory_usage
+
     # --- Misc
     def clear(self):
+        self._discard_journal()
         self._document_id = None
         del self.schedules[:]
         del self.budgets[:]
@@ -903,6 +1003,7 @@ class Document(GUIObject):
         self._cook()
 
     def close(self):
+        self._discard_journal()
         self._save_preferences()
 
     def can_restore_from_prefs(self):
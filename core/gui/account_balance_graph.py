@@ -18,6 +18,13 @@ class AccountBalanceGraph(BalanceGraph):
         entry = entries.last_entry(date)
         return entry.normal_balance() if entry else 0
 
+    def _balance_steps(self, date_range):
+        if self._account is None:
+            return []
+        entries = self.document.accounts.entries_for_account(self._account)
+        normalize = self._account.normalize_amount
+        return [(date, normalize(balance)) for date, balance, _ in entries.balance_steps(date_range)]
+
     # --- Properties
     @property
     def title(self):
@@ -21,12 +21,30 @@ class BrushID:
     GraphNormal = 1
     GraphFuture = 2
 
+def iter_step_points(steps, date_range, balance, today):
+    # Yields (date, balance) for each step as well as for `today` and the end of `date_range`, which
+    # compute_data() always needs. `balance` is the balance before the first step.
+    step_balances = dict(steps)
+    dates = set(step_balances)
+    dates.add(date_range.end)
+    if today in date_range:
+        dates.add(today)
+    for date_point in sorted(dates):
+        balance = step_balances.get(date_point, balance)
+        yield date_point, balance
+
 class BalanceGraph(Graph):
     # BalanceGraph's data point is (float x, float y)
     # --- Virtual
     def _balance_for_date(self, date):
         return 0
 
+    def _balance_steps(self, date_range):
+        # Returns a list of (date, balance) for each date of `date_range` on which the balance might
+        # change, `balance` being the balance at the end of that date. If None, we call
+        # _balance_for_date() for each date of the range instead.
+        return None
+
     def _budget_for_date(self, date):
         return 0
 
@@ -43,8 +61,12 @@ class BalanceGraph(Graph):
         last_balance = self._balance_for_date(date_range.start - ONE_DAY)
         if last_balance:
             date2value[date_range.start] = last_balance
-        for date_point in date_range:
-            balance = self._balance_for_date(date_point)
+        steps = self._balance_steps(date_range)
+        if steps is None:
+            points = ((date_point, self._balance_for_date(date_point)) for date_point in date_range)
+        else:
+            points = iter_step_points(steps, date_range, last_balance, TODAY)
+        for date_point, balance in points:
             if (balance != last_balance) or (date_point == TODAY) or (date_point == date_range.end):
                 if date2value and last_balance != balance:
                     # create a "step"
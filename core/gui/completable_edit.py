@@ -7,7 +7,7 @@
 from core.util import nonone, dedupe
 
 from .base import DocumentGUIObject
-from ..model.completion import CompletionList
+from ..model.completion import CompletionList, CompletionIndex
 
 class CompletableEdit(DocumentGUIObject):
     def __init__(self, mainwindow):
@@ -27,18 +27,23 @@ class CompletableEdit(DocumentGUIObject):
             return
         doc = self.mainwindow.document
         attrname = self.attrname
+        # Description and payee candidates are indexed by our TransactionList as transactions
+        # come and go. They're already stripped and deduplicated.
         if attrname == 'description':
             self._candidates = doc.transactions.descriptions
+            self._complete = doc.transactions.complete_description
         elif attrname == 'payee':
             self._candidates = doc.transactions.payees
+            self._complete = doc.transactions.complete_payee
         elif attrname in {'from', 'to', 'account', 'transfer'}:
             result = doc.transactions.account_names
             # `result` doesn't contain empty accounts' name, so we'll add them.
             result += [a.name for a in doc.accounts if not a.inactive]
             if attrname == 'transfer' and self.account is not None:
                 result = [name for name in result if name != self.account.name]
-            self._candidates = result
-        self._candidates = dedupe([name for name in self._candidates if name.strip()])
+            self._candidates = dedupe([name for name in result if name.strip()])
+            # There are only as many candidates as there are accounts.
+            self._complete = CompletionIndex(self._candidates).complete
 
     def _set_completion(self, completion):
         completion = nonone(completion, '')
@@ -116,7 +121,7 @@ class CompletableEdit(DocumentGUIObject):
     def text(self, value):
         self._text = value
         if self.candidates:
-            self._completions = CompletionList(value, self._candidates)
+            self._completions = CompletionList(value, self._complete)
             self._set_completion(self._completions.current())
         else:
             self._completions = None
@@ -10,7 +10,7 @@ from operator import attrgetter
 from core.util import nonone
 from core.trans import tr
 
-from ..model._ccore import Entry, amount_convert
+from ..model._ccore import Entry, amount_convert, amount_convert_many
 from ..model.date import ONE_DAY
 from ..model.transaction import Transaction
 from .table import Row, RowWithDebitAndCreditMixIn, RowWithDateMixIn, rowattr
@@ -421,7 +421,7 @@ class EntryTableBase(TransactionTableBase):
         selected = len(entries)
         total = sum(1 for row in self if isinstance(row, EntryTableRow))
         total_currency = self._get_totals_currency()
-        amounts = [amount_convert(e.amount, total_currency, e.date) for e in entries]
+        amounts = amount_convert_many([e.amount for e in entries], total_currency, [e.date for e in entries])
         total_debit = sum(a for a in amounts if a > 0)
         total_credit = abs(sum(a for a in amounts if a < 0))
         return (selected, total, total_debit, total_credit)
@@ -4,8 +4,10 @@
 # which should be included with this package. The terms are also available at
 # http://www.gnu.org/licenses/gpl-3.0.html
 
+from collections import defaultdict
+
 from core.trans import tr
-from ..model.date import DateRange
+from ..model.date import DateRange, ONE_DAY
 from .balance_graph import BalanceGraph
 
 class NetWorthGraph(BalanceGraph):
@@ -19,6 +21,25 @@ class NetWorthGraph(BalanceGraph):
 
         return sum(map(bal, self._accounts))
 
+    def _balance_steps(self, date_range):
+        if any(a.currency != self._currency for a in self._accounts):
+            # Converted balances change with exchange rates, which can happen any day.
+            return None
+        start = date_range.start - ONE_DAY
+        deltas = defaultdict(int)
+        for a in self._accounts:
+            entries = self.document.accounts.entries_for_account(a)
+            previous = entries.balance(start, self._currency)
+            for date, balance, _ in entries.balance_steps(date_range):
+                deltas[date] += balance - previous
+                previous = balance
+        balance = self._balance_for_date(start)
+        result = []
+        for date in sorted(deltas):
+            balance += deltas[date]
+            result.append((date, balance))
+        return result
+
     def _budget_for_date(self, date):
         date_range = DateRange(date.min, date)
         return self.document.budgeted_amount(date_range)
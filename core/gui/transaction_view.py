@@ -8,7 +8,7 @@ import weakref
 
 from core.trans import tr
 from ..const import PaneType, FilterType, AccountType
-from ..model._ccore import amount_convert
+from ..model._ccore import amount_convert_many
 from ..model.transaction import txn_matches
 from .base import BaseView
 from .filter_bar import FilterBar
@@ -95,7 +95,8 @@ class TransactionView(TransactionViewBase):
         selected = len(self.mainwindow.selected_transactions)
         total = len(self.visible_transactions)
         currency = self.document.default_currency
-        total_amount = sum(amount_convert(t.amount, currency, t.date) for t in self.mainwindow.selected_transactions)
+        txns = self.mainwindow.selected_transactions
+        total_amount = sum(amount_convert_many([t.amount for t in txns], currency, [t.date for t in txns]))
         total_amount_fmt = self.document.format_amount(total_amount)
         msg = tr("{0} out of {1} selected. Amount: {2}")
         self.status_line = msg.format(selected, total, total_amount_fmt)
@@ -0,0 +1,112 @@
+# Copyright 2019 Virgil Dupras
+#
+# This software is licensed under the "GPLv3" License as described in the "LICENSE" file,
+# which should be included with this package. The terms are also available at
+# http://www.gnu.org/licenses/gpl-3.0.html
+
+import datetime
+import json
+import os.path as op
+
+from ..model._ccore import Transaction
+from ..saver.journal import RECORD_HEADER
+from . import base
+
+def str2date(s):
+    return datetime.date.fromisoformat(s) if s else None
+
+def read_records(path):
+    """Returns the records of the journal at ``path``.
+
+    If there's no journal, returns an empty list. If we crashed while writing the last record, we
+    ignore it.
+    """
+    try:
+        with open(path, 'rb') as fp:
+            data = fp.read()
+    except FileNotFoundError:
+        return []
+    result = []
+    offset = 0
+    while offset + RECORD_HEADER.size <= len(data):
+        size, = RECORD_HEADER.unpack_from(data, offset)
+        offset += RECORD_HEADER.size
+        if offset + size > len(data):
+            break
+        try:
+            result.append(json.loads(data[offset:offset+size].decode('utf-8')))
+        except ValueError:
+            break
+        offset += size
+    return result
+
+def snapshot_path(path, records):
+    """Returns the path of the snapshot that ``records`` apply to, or ``None``.
+
+    ``path`` is the path of the journal ``records`` come from.
+    """
+    if records and records[0].get('op') == 'snapshot':
+        return op.join(op.dirname(path), records[0]['file'])
+    return None
+
+def replay(records, journal, accounts, transactions, properties):
+    """Apply ``records`` to a freshly loaded document.
+
+    ``journal`` is the :class:`.Journal` which was reset with that document and ``properties`` is
+    its property dict.
+    """
+    def replay_account(record):
+        account = journal.find_account(record['id'])
+        if account is None:
+            account = accounts.create(record['name'], record['currency'], record['type'])
+            journal.bind_account(account, record['id'])
+        elif account.name != record['name']:
+            accounts.rename_account(account, record['name'])
+        account.change(
+            currency=record['currency'], type=record['type'], reference=record['reference'],
+            groupname=record['groupname'], account_number=record['account_number'],
+            inactive=record['inactive'], notes=record['notes'])
+
+    def replay_transaction(record):
+        txn = Transaction(
+            1, str2date(record['date']), record['description'], record['payee'],
+            record['checkno'], None, None)
+        txn.notes = record['notes']
+        txn.mtime = record['mtime']
+        txn.position = record['position']
+        for account_id, str_amount, memo, reference, reconciliation_date in record['splits']:
+            account = journal.find_account(account_id) if account_id is not None else None
+            currency = account.currency if account is not None else accounts.default_currency
+            split = txn.new_split()
+            split.account = account
+            split.amount = base.parse_amount(str_amount, currency, strict_currency=True)
+            split.memo = memo
+            split.reference = reference
+            split.reconciliation_date = str2date(reconciliation_date)
+        old = journal.find_transaction(record['id'])
+        if old is not None:
+            transactions.remove(old)
+        transactions.add(txn, True)
+        journal.bind_transaction(txn, record['id'])
+
+    for record in records:
+        kind = record.get('op')
+        if kind == 'account':
+            replay_account(record)
+        elif kind == 'delete_account':
+            account = journal.find_account(record['id'])
+            if account is not None:
+                transactions.reassign_account(account, None)
+                accounts.remove(account)
+                journal.forget_account(account)
+        elif kind == 'transaction':
+            replay_transaction(record)
+        elif kind == 'delete_transaction':
+            txn = journal.find_transaction(record['id'])
+            if txn is not None:
+                transactions.remove(txn)
+                journal.forget_transaction(txn)
+        elif kind == 'properties':
+            for name, value in record['values'].items():
+                if name in properties:
+                    properties[name] = value
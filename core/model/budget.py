@@ -10,7 +10,6 @@ from datetime import date
 
 from core.util import extract
 
-from ._ccore import inc_date
 from .date import DateRange, ONE_DAY
 from .recurrence import get_repeat_type_desc, Spawn, DateCounter, RepeatType
 from .transaction import Transaction
@@ -75,13 +74,20 @@ class Budget:
         return result
 
     def get_spawns(self, start_date, repeat_type, repeat_every, end, transactions, consumedtxns):
-        date_counter = DateCounter(start_date, repeat_type, repeat_every, end)
+        # A period ends the day before the next one starts, so we also need the first start date
+        # after `end`.
+        start_dates = []
+        for current_date in DateCounter(start_date, repeat_type, repeat_every, date.max):
+            start_dates.append(current_date)
+            if current_date > end:
+                break
         spawns = []
         current_ref = Transaction(start_date)
-        for current_date in date_counter:
+        for current_date, next_date in zip(start_dates, start_dates[1:]):
+            if current_date > end:
+                break
             # `recurrence_date` is the date at which the budget *starts*.
-            # We need a date counter to see which date is next (so we can know when our period ends
-            end_date = inc_date(current_date, repeat_type, repeat_every) - ONE_DAY
+            end_date = next_date - ONE_DAY
             if end_date <= date.today():
                 # No spawn in the past
                 continue
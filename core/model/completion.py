@@ -6,26 +6,22 @@
 # which should be included with this package. The terms are also available at 
 # http://www.gnu.org/licenses/gpl-3.0.html
 
-from core.util import dedupe
-
-from .sort import sort_string
+from ._ccore import CompletionIndex
 
 class CompletionList:
     def __init__(self, partial, candidates):
         """Build a completion list.
 
         'partial' is the partial value to be completed
-        'candidates' is the list of candidate values to be tried, the most likely candidate first."""
+        'candidates' is a function returning the completions of a prefix, most likely first (such
+        as CompletionIndex.complete), or the list of candidate values to be tried, the most
+        likely candidate first."""
         if not partial:
             self._completions = None
             return
-        partial = sort_string(partial)
-        candidates = dedupe(c.strip() for c in candidates)
-        self._completions = []
-        for candidate in candidates:
-            normalized = sort_string(candidate)
-            if normalized.startswith(partial):
-                self._completions.append(candidate)
+        if not callable(candidates):
+            candidates = CompletionIndex(candidates).complete
+        self._completions = candidates(partial)
         self._completions.reverse()
         if self._completions:
             self._index = len(self._completions) - 1
@@ -24,6 +24,10 @@ class Oven:
     2. Creates :class:`.Entry` instances to place in :attr:`.Account.entries`. These entries contain
        running totals for each account (which is, of course, calculated).
     """
+    #: Number of threads computing running totals. With 0 or 1, they're computed in the calling
+    #: thread, GIL held.
+    cook_threads = 0
+
     def __init__(self, accounts, transactions, scheduled, budgets):
         self._accounts = accounts
         self._transactions = transactions
@@ -34,6 +38,10 @@ class Oven:
         #: schedule and budget :class:`.Spawn` instances (in date/position order).
         self.transactions = []
 
+    @staticmethod
+    def _accounts_of(transactions):
+        return {split.account for txn in transactions for split in txn.splits if split.account}
+
     def _budget_spawns(self, until_date, schedule_spawns):
         if not self._budgets:
             return []
@@ -44,6 +52,12 @@ class Oven:
         relevant_txns = list(dropwhile(lambda t: t.date < ref_date, self._transactions)) + schedule_spawns
         return self._budgets.get_spawns(until_date, relevant_txns)
 
+    def _spawn_accounts(self, from_date):
+        # Accounts of the spawns we're about to discard, and budgeted accounts (their spawns can
+        # come and go with the amounts they're budgeted against).
+        spawns = [t for t in self.transactions if t.is_spawn and t.date >= from_date]
+        return self._accounts_of(spawns) | {budget.account for budget in self._budgets}
+
     def continue_cooking(self, until_date):
         """Cooks from where we stop last time until ``until_date``.
 
@@ -55,7 +69,7 @@ class Oven:
         if until_date > self._cooked_until:
             self.cook(self._cooked_until, until_date)
 
-    def cook(self, from_date=None, until_date=None):
+    def cook(self, from_date=None, until_date=None, dirty_accounts=None):
         """Cooks raw data into :attr:`transactions`.
 
         :param from_date: when set, saves calculation time by re-using existing cooked transactions.
@@ -64,6 +78,11 @@ class Oven:
                            cooking. If we don't, we might end up in an infinite loop. If not set,
                            will be the date of the transaction with the highest date.
         :type until_date: ``datetime.date``
+        :param dirty_accounts: when set, only the entries of these accounts are re-cooked. It must
+                               contain every account that changed transactions touch, before and
+                               after the change. Accounts touched by schedules and budgets are
+                               added to it because their spawns are re-created at each cook.
+        :type dirty_accounts: set of :class:`.Account`
         """
         # Determine from/until dates
         if from_date is None:
@@ -74,21 +93,16 @@ class Oven:
             # We reverse the transactions to correctly detect chained overlappings in date/recdate
             for txn in reversed(self.transactions): # splits from *cooked* txns
                 for split in txn.splits:
+                    if dirty_accounts is not None and split.account not in dirty_accounts:
+                        continue
                     rdate = split.reconciliation_date
                     if rdate is not None and rdate >= from_date:
                         from_date = min(from_date, txn.date)
         self._transactions.sort() # needed in case until_date is None
         if until_date is None:
             until_date = self._transactions.last().date if self._transactions else from_date
-        # Clear old cooked data
-        for account in self._accounts:
-            entries = self._accounts.entries_for_account(account)
-            entries.clear(from_date)
-        if from_date == date.min:
-            self.transactions = []
-        else:
-            self.transactions = [t for t in self.transactions if t.date < from_date]
-        # Cook
+        # Spawns are re-created at each cook. We create them before clearing anything because
+        # the entries of every account they touch have to be cleared, or they'd be cooked twice.
         if self._scheduled is not None:
             spawns = flatten(recurrence.get_spawns(until_date) for recurrence in self._scheduled)
             spawns += self._budget_spawns(until_date, spawns)
@@ -99,12 +113,27 @@ class Oven:
                 spawn.position = counter
         else:
             spawns = []
+        if dirty_accounts is not None:
+            dirty_accounts = (
+                self._spawn_accounts(from_date) | self._accounts_of(spawns) | dirty_accounts
+            )
+        # Clear old cooked data
+        for account in self._accounts:
+            if dirty_accounts is not None and account not in dirty_accounts:
+                continue
+            entries = self._accounts.entries_for_account(account)
+            entries.clear(from_date)
+        if from_date == date.min:
+            self.transactions = []
+        else:
+            self.transactions = [t for t in self.transactions if t.date < from_date]
+        # Cook
         txns = list(self._transactions) + spawns
         # we don't filter out txns > until_date because they might be budgets affecting current data
         # XXX now that budget's base date is the start date, isn't this untrue?
         tocook = [t for t in txns if from_date <= t.date]
         tocook.sort(key=attrgetter('date'))
-        oven_cook_txns(self._accounts, tocook)
+        oven_cook_txns(self._accounts, tocook, self.cook_threads, dirty_accounts)
         self.transactions += tocook
         self._cooked_until = until_date
 
@@ -12,7 +12,7 @@ from itertools import chain
 from core.util import nonone, first
 from core.trans import tr
 
-from ._ccore import Transaction, inc_date
+from ._ccore import Transaction, recurrence_dates
 from .date import RepeatType
 
 def find_schedule_of_ref(ref, schedules):
@@ -68,15 +68,26 @@ class DateCounter:
                              "weekday" types, ``repeat_every`` is also in months.
     :param datetime.date end: Date at which to stop the iteration.
 
+    Our dates are computed in batches by ``recurrence_dates()``, which returns all dates up to a
+    given date in one go. When we know we'll go through all our dates, calling it directly is
+    faster. Because our end date can be far away (``datetime.date.max``) and we can be stopped
+    early, we ask for dates up to a horizon which we push further, geometrically, as needed. Each
+    batch resumes where the previous one stopped.
+
     .. seealso:: :doc:`/forecast`
     """
     def __init__(self, base_date, repeat_type, repeat_every, end):
         self.base_date = base_date
         self.end = end
-        self.inccount = 0
         self.repeat_type = repeat_type
         self.incsize = repeat_every
-        self.current_date = None
+        self._dates = []
+        self._index = 0
+        # Recurrence increment at which our next batch starts. See recurrence_dates().
+        self._next_increment = 0
+        # Dates up to that horizon have been fetched. None when we haven't started.
+        self._horizon = None
+        self._span = 366
 
     def __iter__(self):
         return self
@@ -84,22 +95,39 @@ class DateCounter:
     def __next__(self):
         # It's possible for a DateCounter to be created with an end date smaller than its start
         # date. In this case, simply never yield any date.
-        if self.base_date > self.end:
-            raise StopIteration()
-        if self.current_date is None: # first date of the iteration is base_date
-            self.current_date = self.base_date
-            return self.current_date
-        new_date = None
-        while new_date is None:
-            self.inccount += self.incsize
-            new_date = inc_date(self.base_date, self.repeat_type, self.inccount)
-        if new_date <= self.current_date or new_date > self.end:
-            raise StopIteration()
-        self.current_date = new_date
-        return new_date
-
-
-def Spawn(recurrence, ref, recurrence_date, date=None, txntype=2):
+        while self._index == len(self._dates):
+            if self._horizon is not None and self._horizon >= self.end:
+                raise StopIteration()
+            if (self.end - self.base_date).days <= self._span:
+                self._horizon = self.end
+            else:
+                self._horizon = self.base_date + datetime.timedelta(days=self._span)
+            self._span *= 2
+            self._dates, self._next_increment = recurrence_dates(
+                self.base_date, self.repeat_type, self.incsize, self._horizon,
+                self._next_increment)
+            self._index = 0
+        result = self._dates[self._index]
+        self._index += 1
+        return result
+
+
+def spawn_template(ref):
+    """Returns a transaction with the splits that spawns of ``ref`` have.
+
+    See the ``template`` argument of :func:`Spawn`.
+    """
+    res = ref.replicate()
+    for split in res.splits:
+        split.reconciliation_date = None
+    res.balance()
+    return res
+
+
+def Spawn(recurrence, ref, recurrence_date, date=None, txntype=2, template=None):
+    # When we have a ``template`` (from :func:`spawn_template`), we share its splits instead of
+    # copying them. All spawns of a schedule can then share the same splits, which are only
+    # copied when the spawn is modified, that is, when it becomes an exception.
     date = date or recurrence_date
     res = Transaction(
         txntype, date, ref.description, ref.payee, ref.checkno, None, None)
@@ -111,6 +139,9 @@ def Spawn(recurrence, ref, recurrence_date, date=None, txntype=2):
     #: :class:`.Transaction`. Template transaction for our spawn. Most of the time, it's the
     #: same as :attr:`Recurrence.ref`, unless we have an "exception" in our schedule.
     res.ref = ref
+    if template is not None:
+        res.share_splits(template)
+        return res
     res.change(splits=ref.splits)
     for split in res.splits:
         split.reconciliation_date = None
@@ -181,8 +212,8 @@ class Recurrence:
         exceptions = chain(self.date2exception.values(), self.date2globalchange.values())
         return (e for e in exceptions if e is not None)
 
-    def _create_spawn(self, ref, date):
-        return Spawn(self, ref, date)
+    def _create_spawn(self, ref, date, template=None):
+        return Spawn(self, ref, date, template=template)
 
     def _update_ref(self):
         # Go through our recurrence dates and see if we should either move our start date due to
@@ -282,11 +313,13 @@ class Recurrence:
                 end += -min_date_delta
         end = min(end, nonone(self.stop_date, datetime.date.max))
 
-        date_counter = DateCounter(self.start_date, self.repeat_type, self.repeat_every, end)
+        dates, _ = recurrence_dates(self.start_date, self.repeat_type, self.repeat_every, end)
         result = []
         global_date_delta = datetime.timedelta(days=0)
         current_ref = self.ref
-        for current_date in date_counter:
+        # ref -> spawn template. Our spawns share the splits of their template.
+        templates = {}
+        for current_date in dates:
             if current_date in self.date2globalchange:
                 current_ref = self.date2globalchange[current_date]
                 global_date_delta = current_ref.date - current_date
@@ -296,7 +329,10 @@ class Recurrence:
                     result.append(exception)
             else:
                 if current_date not in self.date2instances:
-                    spawn = self._create_spawn(current_ref, current_date)
+                    template = templates.get(current_ref)
+                    if template is None:
+                        template = templates[current_ref] = spawn_template(current_ref)
+                    spawn = self._create_spawn(current_ref, current_date, template)
                     if global_date_delta:
                         # Only muck with spawn.date if we have a delta. otherwise we're breaking
                         # budgets.
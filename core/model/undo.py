@@ -52,6 +52,17 @@ class Action:
         self.added_budgets = set()
         self.changed_budgets = {}
         self.deleted_budgets = set()
+        #: Bytes held by our undo step when we last looked. See :attr:`Undoer.memory_usage`.
+        self.footprint = 0
+
+    def only_changes_transactions(self):
+        """Whether our only changes are changes to existing transactions."""
+        return not any([
+            self.added_accounts, self.changed_accounts, self.deleted_accounts,
+            self.added_transactions, self.deleted_transactions,
+            self.added_schedules, self.changed_schedules, self.deleted_schedules,
+            self.added_budgets, self.changed_budgets, self.deleted_budgets,
+        ])
 
     def change_accounts(self, accounts):
         """Record imminent changes to ``accounts``."""
@@ -96,8 +107,13 @@ class Undoer:
     How it works is that it holds a list of :class:`.Action` and a pointer to our current action
     (most of the time, it's the last action). When we undo or redo an action, we use the information
     we has stored in our action and make proper modifications, then move our action index.
+
+    When :attr:`memory_limit` is set, we forget our oldest actions whenever our undo steps hold more
+    than that. When :attr:`merge_changes` is set, consecutive changes to the same transactions are
+    merged in a single action.
     """
-    def __init__(self, accounts, transactions, scheduled, budgets):
+    def __init__(
+            self, accounts, transactions, scheduled, budgets, memory_limit=0, merge_changes=False):
         self._actions = []
         self._accounts = accounts
         self._transactions = transactions
@@ -105,6 +121,16 @@ class Undoer:
         self._budgets = budgets
         self._index = -1
         self._save_point = None
+        self._memory_usage = 0
+        # Whether our last action was recorded and not undone since. Its undo step isn't compacted
+        # yet, so it can absorb further changes to the same transactions.
+        self._last_is_fresh = False
+        #: Maximum number of bytes our undo steps can hold. 0 means no limit.
+        self.memory_limit = memory_limit
+        #: Whether consecutive changes to the same transactions are merged in a single action.
+        self.merge_changes = merge_changes
+        #: If set, called with each action we record, undo or redo, before it's applied.
+        self.on_action = None
 
     # --- Private
     def _do_adds(self, accounts, schedules, budgets):
@@ -128,6 +154,35 @@ class Undoer:
         for budget in budgets:
             self._budgets.remove(budget)
 
+    def _can_merge(self, action):
+        if not (self.merge_changes and self._last_is_fresh):
+            return False
+        last = self._actions[-1]
+        return (
+            last is not self._save_point
+            and last.description == action.description
+            and last.changed_transactions == action.changed_transactions
+            and last.only_changes_transactions()
+            and action.only_changes_transactions()
+        )
+
+    def _refresh_footprint(self, action):
+        footprint = action.undostep.footprint()
+        self._memory_usage += footprint - action.footprint
+        action.footprint = footprint
+
+    def _forget(self, actions):
+        for action in actions:
+            self._memory_usage -= action.footprint
+
+    def _evict(self):
+        # We always keep our latest action.
+        count = 0
+        while self._memory_usage > self.memory_limit and count < len(self._actions) - 1:
+            self._memory_usage -= self._actions[count].footprint
+            count += 1
+        del self._actions[:count]
+
     # --- Public
     def can_redo(self):
         """Whether we can redo.
@@ -147,6 +202,8 @@ class Undoer:
     def clear(self):
         """Clear our action list."""
         self._actions = []
+        self._memory_usage = 0
+        self._last_is_fresh = False
 
     def undo_description(self):
         """Textual description of the action to be undone next."""
@@ -177,6 +234,18 @@ class Undoer:
         :param action: Action to be recorded.
         :type action: :class:`Action`
         """
+        if self.on_action is not None:
+            self.on_action(action)
+        if self._can_merge(action):
+            # Our last undo step still holds the state from before its change, which is what we
+            # want to go back to.
+            return
+        if self.can_undo():
+            # The change recorded by our current action has been made by now, so we can drop what
+            # it didn't touch.
+            current = self._actions[self._index]
+            current.undostep.compact()
+            self._refresh_footprint(current)
         action.undostep = UndoStep(
             action.added_accounts,
             action.deleted_accounts,
@@ -185,9 +254,14 @@ class Undoer:
             action.deleted_transactions,
             action.changed_transactions)
         if self._index < -1:
+            self._forget(self._actions[self._index + 1:])
             self._actions = self._actions[:self._index + 1]
         self._actions.append(action)
         self._index = -1
+        self._refresh_footprint(action)
+        self._last_is_fresh = True
+        if self.memory_limit:
+            self._evict()
 
     def undo(self):
         """Undo the next action to be undone.
@@ -200,7 +274,11 @@ class Undoer:
         """
         assert self.can_undo()
         action = self._actions[self._index]
+        if self.on_action is not None:
+            self.on_action(action)
         action.undostep.undo(self._accounts, self._transactions)
+        self._refresh_footprint(action)
+        self._last_is_fresh = False
         self._do_adds(
             action.deleted_accounts, action.deleted_schedules,
             action.deleted_budgets
@@ -209,7 +287,6 @@ class Undoer:
             action.added_accounts, action.added_schedules, action.added_budgets
         )
         self._do_changes(action)
-        self._transactions.clear_cache()
         self._index -= 1
 
     def redo(self):
@@ -222,6 +299,8 @@ class Undoer:
         """
         assert self.can_redo()
         action = self._actions[self._index + 1]
+        if self.on_action is not None:
+            self.on_action(action)
         action.undostep.redo(self._accounts, self._transactions)
         self._do_adds(
             action.added_accounts, action.added_schedules, action.added_budgets
@@ -231,10 +310,14 @@ class Undoer:
             action.deleted_budgets
         )
         self._do_changes(action)
-        self._transactions.clear_cache()
         self._index += 1
 
     # --- Properties
+    @property
+    def memory_usage(self):
+        """Number of bytes held by our undo steps."""
+        return self._memory_usage
+
     @property
     def modified(self):
         """Whether we can consider our document modified.
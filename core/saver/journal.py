@@ -0,0 +1,260 @@
+# Copyright 2019 Virgil Dupras
+#
+# This software is licensed under the "GPLv3" License as described in the "LICENSE" file,
+# which should be included with this package. The terms are also available at
+# http://www.gnu.org/licenses/gpl-3.0.html
+
+import json
+import os
+import os.path as op
+import struct
+import uuid
+
+from ..model._ccore import amount_format
+
+#: Appended to the path of a document to get the path of its journal.
+JOURNAL_SUFFIX = '.journal'
+# Each record is a JSON object prefixed with its size in bytes.
+RECORD_HEADER = struct.Struct('<I')
+
+def date2str(date):
+    return date.isoformat() if date is not None else None
+
+def pack_record(record):
+    data = json.dumps(record).encode('utf-8')
+    return RECORD_HEADER.pack(len(data)) + data
+
+class Journal:
+    """Append-only log of the changes made to a saved document since it was last saved.
+
+    Rather than rewriting the whole document each time we autosave, we write the current state of
+    the accounts and transactions that were touched since the last autosave to a journal next to
+    the document. When the document is loaded and there's a journal next to it, it means that we
+    crashed with unsaved changes and we replay it (see :mod:`core.loader.journal`). The journal is
+    discarded when the document is saved or closed.
+
+    Accounts and transactions are identified by ids which, when the journal starts, are their
+    index in the document as it was saved. This way, ids are the same when the document is
+    loaded back. Accounts and transactions added afterwards get new ids.
+
+    Changes to schedules and budgets aren't journaled. When there are some, we write a snapshot of
+    the whole document next to it and restart the journal from there.
+
+    :param str path: Path of the journal file.
+    """
+    def __init__(self, path):
+        self.path = path
+        self._account2id = {}
+        self._id2account = {}
+        self._txn2id = {}
+        self._id2txn = {}
+        self._next_id = 0
+        self._properties = {}
+        # Accounts and transactions touched since our last flush
+        self._accounts = set()
+        self._transactions = set()
+        self._needs_snapshot = False
+        # Whether our file has been written to since we were last reset. If it hasn't, it might be
+        # a leftover which we have to overwrite.
+        self._started = False
+        # File name of the snapshot our journal applies to, if any.
+        self._snapshot = None
+
+    # --- Private
+    def _account_record(self, account):
+        return {
+            'op': 'account',
+            'id': self._bind(self._account2id, self._id2account, account),
+            'name': account.name,
+            'currency': account.currency,
+            'type': account.type,
+            'groupname': account.groupname,
+            'reference': account.reference,
+            'account_number': account.account_number,
+            'inactive': account.inactive,
+            'notes': account.notes,
+        }
+
+    def _bind(self, obj2id, id2obj, obj, id=None):
+        if id is None:
+            id = obj2id.get(obj)
+            if id is not None:
+                return id
+            id = self._next_id
+        elif id in id2obj:
+            # We're replacing the former holder of that id.
+            obj2id.pop(id2obj[id], None)
+        obj2id[obj] = id
+        id2obj[id] = obj
+        self._next_id = max(self._next_id, id + 1)
+        return id
+
+    def _remove_file(self, filename):
+        try:
+            os.remove(filename)
+        except FileNotFoundError:
+            pass
+
+    def _transaction_record(self, txn):
+        splits = []
+        for split in txn.splits:
+            account_id = self._account2id.get(split.account) if split.account is not None else None
+            splits.append([
+                account_id, amount_format(split.amount), split.memo, split.reference,
+                date2str(split.reconciliation_date),
+            ])
+        return {
+            'op': 'transaction',
+            'id': self._bind(self._txn2id, self._id2txn, txn),
+            'date': date2str(txn.date),
+            'description': txn.description,
+            'payee': txn.payee,
+            'checkno': txn.checkno,
+            'notes': txn.notes,
+            'mtime': txn.mtime,
+            'position': txn.position,
+            'splits': splits,
+        }
+
+    def _unbind(self, obj2id, id2obj, obj):
+        id = obj2id.pop(obj, None)
+        if id is not None:
+            del id2obj[id]
+        return id
+
+    def _write(self, path, records, mode):
+        with open(path, mode) as fp:
+            fp.write(b''.join(pack_record(r) for r in records))
+            fp.flush()
+            os.fsync(fp.fileno())
+
+    def _write_snapshot(self, accounts, transactions, properties, write_document):
+        dirname = op.dirname(self.path)
+        oldname = self._snapshot
+        newname = '{}.{}'.format(op.basename(self.path), uuid.uuid4().hex)
+        write_document(op.join(dirname, newname))
+        self.reset(accounts, transactions, properties)
+        # We only replace our journal once the new snapshot is complete. Until then, a crash
+        # leaves us with our former journal and snapshot.
+        tmppath = self.path + '.tmp'
+        self._write(tmppath, [{'op': 'snapshot', 'file': newname}], 'wb')
+        os.replace(tmppath, self.path)
+        if oldname:
+            self._remove_file(op.join(dirname, oldname))
+        self._snapshot = newname
+        self._started = True
+
+    # --- Public
+    def bind_account(self, account, id):
+        """Give ``id`` to ``account``."""
+        self._bind(self._account2id, self._id2account, account, id)
+
+    def bind_transaction(self, txn, id):
+        """Give ``id`` to ``txn``."""
+        self._bind(self._txn2id, self._id2txn, txn, id)
+
+    def discard(self):
+        """Remove our journal and snapshot files."""
+        self._remove_file(self.path)
+        if self._snapshot:
+            self._remove_file(op.join(op.dirname(self.path), self._snapshot))
+            self._snapshot = None
+        self._started = False
+
+    def find_account(self, id):
+        """Returns the account with ``id`` or ``None``."""
+        return self._id2account.get(id)
+
+    def find_transaction(self, id):
+        """Returns the transaction with ``id`` or ``None``."""
+        return self._id2txn.get(id)
+
+    def forget_account(self, account):
+        """Remove ``account``'s id."""
+        self._unbind(self._account2id, self._id2account, account)
+
+    def forget_transaction(self, txn):
+        """Remove ``txn``'s id."""
+        self._unbind(self._txn2id, self._id2txn, txn)
+
+    def flush(self, accounts, transactions, properties, write_document):
+        """Write the current state of what was touched since our last flush.
+
+        ``accounts``, ``transactions`` and ``properties`` are those of our document.
+        ``write_document`` is a function writing the whole document at the path we give it, which
+        we use for snapshots.
+        """
+        if self._needs_snapshot:
+            self._write_snapshot(accounts, transactions, properties, write_document)
+            return
+        # Deleted accounts come first because when we replay them, their splits are unassigned,
+        # and accounts of the same name can be added back.
+        records = []
+        for account in self._accounts:
+            if account not in accounts:
+                id = self._unbind(self._account2id, self._id2account, account)
+                if id is not None:
+                    records.append({'op': 'delete_account', 'id': id})
+        for account in self._accounts:
+            if account in accounts:
+                records.append(self._account_record(account))
+        for txn in self._transactions:
+            if txn in transactions:
+                records.append(self._transaction_record(txn))
+            else:
+                id = self._unbind(self._txn2id, self._id2txn, txn)
+                if id is not None:
+                    records.append({'op': 'delete_transaction', 'id': id})
+        if properties != self._properties:
+            records.append({'op': 'properties', 'values': properties})
+            self._properties = dict(properties)
+        self._accounts = set()
+        self._transactions = set()
+        if records:
+            self._write(self.path, records, 'ab' if self._started else 'wb')
+            self._started = True
+
+    def note(self, action):
+        """Remember what ``action`` touches so that we write it on our next :meth:`flush`.
+
+        This has to be called for all recorded, undone and redone actions.
+        """
+        self._accounts |= action.added_accounts | action.changed_accounts | action.deleted_accounts
+        self._transactions |= (
+            action.added_transactions | action.changed_transactions | action.deleted_transactions
+        )
+        if any([
+                action.added_schedules, action.changed_schedules, action.deleted_schedules,
+                action.added_budgets, action.changed_budgets, action.deleted_budgets]):
+            self._needs_snapshot = True
+
+    def reset(self, accounts, transactions, properties):
+        """Start over with a journal for a document that was just saved.
+
+        ``accounts`` and ``transactions`` must be iterated in the order in which they were saved.
+        """
+        self._account2id = {}
+        self._id2account = {}
+        self._txn2id = {}
+        self._id2txn = {}
+        self._next_id = 0
+        for i, account in enumerate(accounts):
+            self.bind_account(account, i)
+        for i, txn in enumerate(transactions):
+            self.bind_transaction(txn, i)
+        self._properties = dict(properties)
+        self._accounts = set()
+        self._transactions = set()
+        self._needs_snapshot = False
+        self._started = False
+        self._snapshot = None
+
+    def resume(self, snapshot, properties):
+        """Keep on appending to a journal we've just replayed.
+
+        ``snapshot`` is the file name of the snapshot it applies to, if any, and ``properties``
+        are the document properties after the replay.
+        """
+        self._properties = dict(properties)
+        self._snapshot = snapshot
+        self._started = True
@@ -184,6 +184,17 @@ def test_complete_latest_modified(app):
     app.etable.delete()
     eq_(complete_etable(app, 'De', 'description'), 'posit')
 
+@with_app(app_one_entry)
+def test_complete_follows_changes_and_undo(app):
+    # Completions follow transaction changes, including those made by undo and redo.
+    app.etable[0].description = 'Debit'
+    app.etable.save_edits()
+    eq_(complete_etable(app, 'De', 'description'), 'bit')
+    app.doc.undo()
+    eq_(complete_etable(app, 'De', 'description'), 'posit')
+    app.doc.redo()
+    eq_(complete_etable(app, 'De', 'description'), 'bit')
+
 @with_app(app_one_entry)
 def test_complete_partial(app):
     # Partial match returns the attribute of the matched entry.
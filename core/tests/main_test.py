@@ -6,12 +6,13 @@
 
 import sys
 import os
+import os.path as op
 from datetime import date
 
 from pytest import raises
 from .testutil import eq_
 
-from .base import ApplicationGUI, TestApp, with_app, testdata
+from .base import ApplicationGUI, TestApp, with_app, testdata, compare_apps
 from ..app import Application
 from ..document import Document, AUTOSAVE_BUFFER_COUNT
 from ..exception import FileFormatError
@@ -189,6 +190,59 @@ def test_autosave(app, tmpdir):
     # The extra autosave file has been deleted
     eq_(len(os.listdir(cache_path)), AUTOSAVE_BUFFER_COUNT)
 
+@with_app(app_one_empty_account_range_on_october_2007)
+def test_autosave_journals_changes_to_saved_file(app, tmpdir):
+    # Once a document has a file, autosave appends changes to a journal next to it instead of
+    # writing the whole document. That journal is replayed when the file is loaded after a crash.
+    app.app.cache_path = str(tmpdir.join('cache'))
+    filename = str(tmpdir.join('foo.moneyguru'))
+    app.add_entry('1/10/2007', description='first', increase='1')
+    app.add_entry('2/10/2007', description='second', increase='2')
+    app.doc.save_to_xml(filename)
+    app.app.autosave_interval = 1
+    app.etable.select([0])
+    app.etable.selected_row.description = 'changed'
+    app.etable.save_edits()
+    app.add_account('Savings')
+    app.show_account()
+    app.add_entry('3/10/2007', description='third', transfer='Checking', decrease='3')
+    app.show_account('Checking')
+    app.etable.select([1])
+    app.mw.delete_item()
+    assert op.exists(filename + '.journal')
+    assert not op.exists(str(tmpdir.join('cache')))
+    newapp = TestApp()
+    newapp.mw.load_from_xml(filename)
+    assert newapp.doc.is_dirty()
+    compare_apps(app.doc, newapp.doc)
+    # An explicit save folds the journal in the file
+    newapp.mw.save_to_xml(filename)
+    assert not op.exists(filename + '.journal')
+    newapp = TestApp()
+    newapp.mw.load_from_xml(filename)
+    assert not newapp.doc.is_dirty()
+    compare_apps(app.doc, newapp.doc)
+
+@with_app(app_one_empty_account_range_on_october_2007)
+def test_journal_snapshots_schedule_changes(app, tmpdir):
+    # Changes to schedules aren't journaled, so we snapshot the whole document next to its file
+    # and journal subsequent changes from there.
+    filename = str(tmpdir.join('foo.moneyguru'))
+    app.doc.save_to_xml(filename)
+    app.app.autosave_interval = 1
+    app.add_schedule(start_date='13/09/2007', account='Checking', amount='1', repeat_every=3)
+    app.show_account('Checking')
+    app.add_entry('1/10/2007', description='after', increase='1')
+    app.add_account('Savings')
+    eq_(len(tmpdir.listdir()), 3) # file, journal, snapshot
+    newapp = TestApp()
+    newapp.mw.load_from_xml(filename)
+    newapp.drsel.set_date_range(app.doc.date_range)
+    newapp.doc._cook()
+    compare_apps(app.doc, newapp.doc)
+    newapp.mw.close()
+    eq_(len(tmpdir.listdir()), 1)
+
 @with_app(app_one_empty_account_range_on_october_2007)
 def test_balance_recursion_limit(app):
     # Balance calculation don't cause recursion errors when there's a lot of them.
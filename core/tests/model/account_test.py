@@ -67,6 +67,27 @@ class TestOneAccount:
         # Each entry is converted using the entry's day rate.
         eq_(entries.cash_flow(range, 'CAD'), Amount(201.40, 'CAD'))
 
+def test_cook_dirty_accounts():
+    # When the oven is given dirty accounts, only their entries are re-cooked.
+    accounts = AccountList('USD')
+    checking = accounts.create('Checking', 'USD', AccountType.Asset)
+    savings = accounts.create('Savings', 'USD', AccountType.Asset)
+    txn1 = Transaction(date(2008, 1, 1), account=checking, amount=Amount(10, 'USD'))
+    txn2 = Transaction(date(2008, 1, 2), account=savings, amount=Amount(20, 'USD'))
+    transactions = TransactionList()
+    transactions.add(txn1)
+    transactions.add(txn2)
+    oven = Oven(accounts, transactions, [], [])
+    oven.cook(date.min, date.max)
+    txn1.splits[0].amount = Amount(11, 'USD')
+    txn2.splits[0].amount = Amount(21, 'USD')
+    oven.cook(date(2008, 1, 1), date.max, dirty_accounts={checking})
+    eq_(accounts.entries_for_account(checking).balance(date.max, 'USD'), Amount(11, 'USD'))
+    # Savings wasn't marked as dirty, so it wasn't re-cooked.
+    eq_(accounts.entries_for_account(savings).balance(date.max, 'USD'), Amount(20, 'USD'))
+    eq_(len(accounts.entries_for_account(savings)), 1)
+    eq_(oven.transactions, [txn1, txn2])
+
 def test_accountlist_contains():
     # AccountList membership is based on account name, not Account instances.
     # Account name tests are exact though, so it's not the exact same thing
@@ -45,6 +45,16 @@ def test_physical_rates_db_remember_rates(tmpdir):
     db = RatesDB(dbpath)
     assert_almost_equal(db.get_rate(date(2008, 4, 20), 'CAD', 'USD'), 0.996115, places=6)
 
+def test_physical_rates_db_remember_bulk_rates(tmpdir):
+    # Rates saved in bulk with set_CAD_values are remembered as well.
+    dbpath = str(tmpdir.join('foo.db'))
+    db = RatesDB(dbpath)
+    db.set_CAD_values('USD', [(date(2008, 4, 20), 1/0.996115), (date(2008, 4, 22), 1/0.997115)])
+    db = RatesDB(dbpath)
+    assert_almost_equal(db.get_rate(date(2008, 4, 20), 'CAD', 'USD'), 0.996115, places=6)
+    assert_almost_equal(db.get_rate(date(2008, 4, 21), 'CAD', 'USD'), 0.996115, places=6)
+    assert_almost_equal(db.get_rate(date(2008, 4, 22), 'CAD', 'USD'), 0.997115, places=6)
+
 def xtest_corrupt_db(tmpdir):
     # todo: cover this
     dbpath = str(tmpdir.join('foo.db'))
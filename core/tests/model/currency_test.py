@@ -10,7 +10,7 @@ import time
 from pytest import raises
 from ..testutil import jointhreads, eq_
 
-from ...model._ccore import amount_convert
+from ...model._ccore import amount_convert, amount_convert_many
 from ...model.currency import (
     Currencies, RateProviderUnavailable, RatesDB)
 from ...model.currency_provider import boc
@@ -64,6 +64,19 @@ def test_seek_rate():
     eq_(amount_convert(amount, 'CAD', date(2008, 5, 21)), expected)
     eq_(amount_convert(amount, 'CAD', date(2008, 5, 19)), expected)
 
+def test_convert_many():
+    # amount_convert_many() gives the same results as amount_convert() on each amount.
+    set_ratedb_for_tests()
+    Currencies.get_rates_db().set_CAD_value(date(2008, 5, 20), 'USD', 0.98)
+    Currencies.get_rates_db().set_CAD_value(date(2008, 5, 22), 'USD', 0.99)
+    Currencies.get_rates_db().set_CAD_value(date(2008, 5, 20), 'EUR', 1.42)
+    amounts = [Amount(42, 'USD'), Amount(12, 'CAD'), 0, Amount(1, 'EUR'), Amount(2, 'USD'), Amount(3, 'USD')]
+    dates = [date(2008, 5, 21), date(2008, 5, 21), date(2008, 5, 21), date(2008, 5, 21), date(2008, 5, 22),
+        date(2008, 5, 21)]
+    expected = [amount_convert(a, 'CAD', d) for a, d in zip(amounts, dates)]
+    eq_(amount_convert_many(amounts, 'CAD', dates), expected)
+    eq_(amount_convert_many([], 'CAD', []), [])
+
 # ---
 def test_ask_for_rates_in_the_past():
     # If a rate is asked for a date lower than the lowest fetched date, fetch that range.
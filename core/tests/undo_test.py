@@ -739,3 +739,43 @@ def test_delete_account_with_budget(app, checkstate):
 def test_delete_budget(app, checkstate):
     app.btable.delete()
     checkstate()
+
+# --- Memory limit
+@with_app(TestApp)
+def test_memory_limit_forgets_oldest_actions(app):
+    # When our undo history holds more than the memory limit, the oldest actions are forgotten, but
+    # the latest one is always kept.
+    app.doc._undoer.memory_limit = 1
+    app.add_txn(description='first')
+    app.add_txn(description='second')
+    assert app.doc.undo_memory_usage() > 0
+    app.mw.undo()
+    assert not app.doc.can_undo()
+    eq_(app.ttable.row_count, 1)
+
+@with_app(TestApp)
+def test_merge_changes(app):
+    # With merge_changes, consecutive changes to the same transaction are merged in a single
+    # action, which undoes them all. It doesn't depend on the memory limit.
+    app.doc._undoer.merge_changes = True
+    app.add_txn(description='foo')
+    app.ttable[0].description = 'bar'
+    app.ttable.save_edits()
+    app.ttable[0].description = 'baz'
+    app.ttable.save_edits()
+    app.mw.undo()
+    eq_(app.ttable[0].description, 'foo')
+    app.mw.undo()
+    assert not app.doc.can_undo()
+
+@with_app(TestApp)
+def test_memory_limit_alone_doesnt_merge(app):
+    # A memory limit doesn't make an undoer merge changes by itself.
+    app.doc._undoer.memory_limit = 1024 * 1024
+    app.add_txn(description='foo')
+    app.ttable[0].description = 'bar'
+    app.ttable.save_edits()
+    app.ttable[0].description = 'baz'
+    app.ttable.save_edits()
+    app.mw.undo()
+    eq_(app.ttable[0].description, 'bar')